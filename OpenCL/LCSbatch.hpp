@@ -0,0 +1,196 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "LCSbitpar.hpp"
+#include "clRuntime.hpp"
+
+/*
+    Batched LCS: many (A, B) pairs scored by 1 kernel launch
+    Input:  packed sequences + offsets (SeqPack), pairs as index pairs into the pack
+    Output: 1 contiguous int buffer of LCS lengths, optional subsequences in 1 contiguous char buffer
+
+    Device: 1 work-group per pair, anti-diagonal wavefront over 3 rolling diagonals in __local mem
+    (shorter sequence <= LCS_BATCH_MAXLEN). Longer pairs come back as -1 and are finished on host.
+    Host fallback: OpenMP over pairs, bit-parallel engine per pair.
+*/
+
+#define LCS_BATCH_MAXLEN 2048
+#define LCS_BATCH_WG 64
+
+inline const char* const lcsBatchKern = R"(
+__kernel void lcs_batch(__global const char* seqs, __global const int* offs,
+                        __global const int2* pairs, __global int* lens) {
+    __local int D[3][MAXLEN + 1]; // diagonal d lives in D[d % 3], indexed by row i
+    __local char a_l[MAXLEN];
+
+    int p = get_group_id(0);
+    int lid = get_local_id(0);
+    int wg = get_local_size(0);
+
+    int2 pr = pairs[p];
+    __global const char* a = seqs + offs[pr.x];
+    __global const char* b = seqs + offs[pr.y];
+    int m = offs[pr.x + 1] - offs[pr.x];
+    int n = offs[pr.y + 1] - offs[pr.y];
+    if (m > n) { // rows = shorter sequence
+        __global const char* t = a; a = b; b = t;
+        int tn = m; m = n; n = tn;
+    }
+    // uniform over the work-group, so returning before the barriers is safe
+    if (m > MAXLEN || m == 0) {
+        if (lid == 0)
+            lens[p] = (m == 0) ? 0 : -1;
+        return;
+    }
+
+    for (int i = lid; i < m; i += wg)
+        a_l[i] = a[i];
+    if (lid == 0) {
+        D[0][0] = 0; // (0, 0)
+        D[1][0] = 0; // (0, 1)
+        D[1][1] = 0; // (1, 0)
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int d = 2; d <= m + n; d++) {
+        int c = d % 3;
+        int p1 = (d + 2) % 3; // d - 1
+        int p2 = (d + 1) % 3; // d - 2
+        int lo = max(1, d - n);
+        int hi = min(m, d - 1);
+        for (int i = lo + lid; i <= hi; i += wg) {
+            if (a_l[i - 1] == b[d - i - 1])
+                D[c][i] = D[p2][i - 1] + 1;
+            else
+                D[c][i] = max(D[p1][i - 1], D[p1][i]);
+        }
+        // zero padding: cells (0, d) & (d, 0)
+        if (lid == 0) {
+            D[c][0] = 0;
+            if (d <= m)
+                D[c][d] = 0;
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (lid == 0)
+        lens[p] = D[(m + n) % 3][m];
+}
+)";
+
+
+
+// Packed sequences: sequence k = seqs[offs[k], offs[k + 1])
+struct SeqPack {
+    std::vector<char> seqs;
+    std::vector<int> offs{ 0 };
+
+    int add(std::string_view s) {
+        seqs.insert(seqs.end(), s.begin(), s.end());
+        offs.push_back(seqs.size());
+        return offs.size() - 2;
+    }
+    int size() const { return offs.size() - 1; }
+    std::string_view operator[](int k) const { return std::string_view(seqs.data() + offs[k], offs[k + 1] - offs[k]); }
+};
+
+
+
+// ------ Host fallback ------
+// pairs: 2 ints per pair. Only entries of lens still < 0 are computed when onlyMissing
+inline void lcsBatchHost(const SeqPack& pack, const std::vector<int>& pairs, std::vector<int>& lens, bool onlyMissing = false) {
+    int nPairs = pairs.size() / 2;
+    lens.resize(nPairs);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int p = 0; p < nPairs; p++) {
+        if (onlyMissing && lens[p] >= 0)
+            continue;
+        std::string_view a = pack[pairs[2 * p]];
+        std::string_view b = pack[pairs[2 * p + 1]];
+        lens[p] = a.size() < b.size() ? LCSBitpar(a).length(b) : LCSBitpar(b).length(a);
+    }
+}
+
+// Subsequences of all pairs into 1 buffer: pair p = out[outOffs[p], outOffs[p + 1]), sized by lens
+inline void lcsBatchSeqs(const SeqPack& pack, const std::vector<int>& pairs, const std::vector<int>& lens,
+                         std::vector<char>& out, std::vector<int>& outOffs) {
+    int nPairs = pairs.size() / 2;
+    outOffs.assign(nPairs + 1, 0);
+    for (int p = 0; p < nPairs; p++)
+        outOffs[p + 1] = outOffs[p] + lens[p];
+    out.resize(outOffs[nPairs]);
+
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int p = 0; p < nPairs; p++) {
+        std::string s = lcsSeqBitpar(pack[pairs[2 * p]], pack[pairs[2 * p + 1]]);
+        std::memcpy(out.data() + outOffs[p], s.data(), s.size());
+    }
+}
+
+
+
+// ------ Device batch ------
+// Program is built once (binary cache across runs), buffers come from the runtime's pool and only grow:
+// repeated batches pay no setup and make no new device allocations
+class LCSBatch {
+public:
+    explicit LCSBatch(ClRuntime& rt = ClRuntime::get())
+        : rt_(rt), qu_(rt.queue()) {
+        std::string opts = "-D MAXLEN=" + std::to_string(LCS_BATCH_MAXLEN);
+        prog_ = rt_.program(lcsBatchKern, opts);
+        kern_ = cl::Kernel(prog_, "lcs_batch");
+        wg_ = std::min<size_t>(LCS_BATCH_WG, rt_.device().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+    }
+
+    // lens: 1 per pair. out / outOffs: subsequences when non-null
+    void run(const SeqPack& pack, const std::vector<int>& pairs, std::vector<int>& lens,
+             std::vector<char>* out = nullptr, std::vector<int>* outOffs = nullptr) {
+        int nPairs = pairs.size() / 2;
+        lens.resize(nPairs);
+        if (nPairs == 0)
+            return;
+
+        reserve(buf_seqs_, std::max<size_t>(1, pack.seqs.size()));
+        reserve(buf_offs_, sizeof(int) * pack.offs.size());
+        reserve(buf_pairs_, sizeof(int) * pairs.size());
+        reserve(buf_lens_, sizeof(int) * nPairs);
+
+        if (!pack.seqs.empty())
+            qu_.enqueueWriteBuffer(*buf_seqs_, CL_FALSE, 0, pack.seqs.size(), pack.seqs.data());
+        qu_.enqueueWriteBuffer(*buf_offs_, CL_FALSE, 0, sizeof(int) * pack.offs.size(), pack.offs.data());
+        qu_.enqueueWriteBuffer(*buf_pairs_, CL_FALSE, 0, sizeof(int) * pairs.size(), pairs.data());
+
+        kern_.setArg(0, *buf_seqs_);
+        kern_.setArg(1, *buf_offs_);
+        kern_.setArg(2, *buf_pairs_);
+        kern_.setArg(3, *buf_lens_);
+        qu_.enqueueNDRangeKernel(kern_, cl::NullRange, cl::NDRange(nPairs * wg_), cl::NDRange(wg_));
+        qu_.enqueueReadBuffer(*buf_lens_, CL_TRUE, 0, sizeof(int) * nPairs, lens.data());
+
+        // Pairs over LCS_BATCH_MAXLEN
+        lcsBatchHost(pack, pairs, lens, true);
+
+        if (out && outOffs)
+            lcsBatchSeqs(pack, pairs, lens, *out, *outOffs);
+    }
+
+private:
+    // Too small: hand it back, take a bigger size class (same queue, so in-flight use is safe)
+    void reserve(PooledBuffer& buf, size_t bytes) {
+        if (bytes > buf.capacity())
+            buf = rt_.pool().acquire(bytes);
+    }
+
+    ClRuntime& rt_;
+    cl::CommandQueue& qu_;
+    cl::Program prog_;
+    cl::Kernel kern_;
+    size_t wg_;
+
+    PooledBuffer buf_seqs_, buf_offs_, buf_pairs_, buf_lens_;
+};
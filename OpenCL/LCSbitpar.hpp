@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+/*
+    Bit-parallel LCS (Allison-Dix / Hyyro)
+    Neighbouring cells of a DP row differ by 0 or 1, so row i is stored as a bit vector V_i over B:
+    bit j = 0 <=> tab[i][j + 1] = tab[i][j] + 1.  LCS(A[0, i), B) = #zero bits of V_i.
+    With PM[c] = match mask of char c in B, 1 row = 64 columns per word:
+        U = V & PM[a_i]
+        V = (V + U) | (V & ~PM[a_i])
+    The add carries across words. AVX2 / AVX-512 paths do 4 / 8 words at once and resolve
+    the inter-lane carries with 1 scalar add (carry-lookahead over the lane masks).
+    Build w/ -mavx2 or -mavx512f (-march=native) to enable them.
+*/
+
+#define LCS_BITPAR_LANES 8 // words per block, row length padded to a multiple of it
+
+
+
+// V_out = (V_in + U) | (V_in & ~M), V_in == V_out allowed
+inline void bitparStep(const uint64_t* vin, uint64_t* vout, const uint64_t* pm, size_t words) {
+    uint64_t carry = 0;
+    size_t w = 0;
+
+#if defined(__AVX512F__)
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i ones = _mm512_set1_epi64(-1);
+    for (; w + 8 <= words; w += 8) {
+        __m512i v = _mm512_loadu_si512(vin + w);
+        __m512i mk = _mm512_loadu_si512(pm + w);
+        __m512i u = _mm512_and_si512(v, mk);
+        __m512i x = _mm512_add_epi64(v, u);
+        // lane generates a carry (x < v) / propagates an incoming one (x == ~0)
+        uint32_t g = _mm512_cmplt_epu64_mask(x, v);
+        uint32_t p = _mm512_cmpeq_epi64_mask(x, ones);
+        uint32_t c = ((g | p) + g + (uint32_t)carry) ^ p; // bit i: carry into lane i, bit 8: out
+        x = _mm512_mask_add_epi64(x, (__mmask8)c, x, one);
+        _mm512_storeu_si512(vout + w, _mm512_or_si512(x, _mm512_andnot_si512(mk, v)));
+        carry = (c >> 8) & 1;
+    }
+#elif defined(__AVX2__)
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    const __m256i shift = _mm256_setr_epi64x(0, 1, 2, 3);
+    for (; w + 4 <= words; w += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(vin + w));
+        __m256i mk = _mm256_loadu_si256((const __m256i*)(pm + w));
+        __m256i u = _mm256_and_si256(v, mk);
+        __m256i x = _mm256_add_epi64(v, u);
+        // no unsigned 64-bit compare in AVX2: flip the sign bits
+        __m256i gv = _mm256_cmpgt_epi64(_mm256_xor_si256(v, sign), _mm256_xor_si256(x, sign));
+        __m256i pv = _mm256_cmpeq_epi64(x, ones);
+        uint32_t g = _mm256_movemask_pd(_mm256_castsi256_pd(gv));
+        uint32_t p = _mm256_movemask_pd(_mm256_castsi256_pd(pv));
+        uint32_t c = ((g | p) + g + (uint32_t)carry) ^ p;
+        __m256i cv = _mm256_and_si256(_mm256_srlv_epi64(_mm256_set1_epi64x(c), shift), one);
+        x = _mm256_add_epi64(x, cv);
+        _mm256_storeu_si256((__m256i*)(vout + w), _mm256_or_si256(x, _mm256_andnot_si256(mk, v)));
+        carry = (c >> 4) & 1;
+    }
+#endif
+
+    for (; w < words; w++) {
+        uint64_t v = vin[w];
+        uint64_t mk = pm[w];
+        uint64_t u = v & mk;
+        uint64_t x = v + u;
+        uint64_t c1 = x < v;
+        x += carry;
+        carry = c1 | (x < carry);
+        vout[w] = x | (v & ~mk);
+    }
+}
+
+// #zero bits among the first nbits of V
+inline size_t bitparZeros(const uint64_t* v, size_t nbits) {
+    size_t ones = 0;
+    size_t full = nbits / 64;
+    for (size_t w = 0; w < full; w++)
+        ones += __builtin_popcountll(v[w]);
+    if (nbits % 64)
+        ones += __builtin_popcountll(v[full] & ((1ULL << (nbits % 64)) - 1));
+    return nbits - ones;
+}
+
+
+
+// Match masks of B are built once, then any number of A's can be scored against it
+class LCSBitpar {
+public:
+    explicit LCSBitpar(std::string_view b)
+        : n_(b.size()),
+          words_((b.size() + 64 * LCS_BITPAR_LANES - 1) / (64 * LCS_BITPAR_LANES) * LCS_BITPAR_LANES),
+          pm_(256 * words_, 0) {
+        for (size_t j = 0; j < n_; j++)
+            pm_[(unsigned char)b[j] * words_ + j / 64] |= 1ULL << (j % 64);
+    }
+
+    size_t length(std::string_view a) const {
+        std::vector<uint64_t> v(words_, ~0ULL);
+        for (char c : a)
+            bitparStep(v.data(), v.data(), mask(c), words_);
+        return bitparZeros(v.data(), n_);
+    }
+
+    // Keeps all m + 1 row vectors: (m + 1) * n / 8 bytes, 32x less than the int table
+    std::string seq(std::string_view a) const {
+        size_t m = a.size();
+        std::vector<uint64_t> rows((m + 1) * words_);
+        std::fill(rows.begin(), rows.begin() + words_, ~0ULL);
+        for (size_t i = 1; i <= m; i++)
+            bitparStep(&rows[(i - 1) * words_], &rows[i * words_], mask(a[i - 1]), words_);
+
+        // Table traversal from the very last elem, L = tab[r][c] = zeros of V_r in [0, c)
+        std::string seq;
+        size_t r_trav = m;
+        size_t c_trav = n_;
+        size_t L = bitparZeros(&rows[m * words_], n_);
+        while (L > 0) {
+            const uint64_t* v = &rows[r_trav * words_];
+            size_t j = c_trav - 1;
+            if ((v[j / 64] >> (j % 64)) & 1) { // tab[r][c - 1] == L
+                c_trav -= 1;
+                continue;
+            }
+            // tab[r][c - 1] == L - 1: either the top cell holds L or this is a match
+            if (bitparZeros(&rows[(r_trav - 1) * words_], c_trav) == L) {
+                r_trav -= 1;
+                continue;
+            }
+            seq += a[r_trav - 1];
+            r_trav -= 1;
+            c_trav -= 1;
+            L -= 1;
+        }
+        std::reverse(seq.begin(), seq.end());
+        return seq;
+    }
+
+private:
+    const uint64_t* mask(char c) const { return &pm_[(unsigned char)c * words_]; }
+
+    size_t n_;
+    size_t words_;
+    std::vector<uint64_t> pm_; // 256 x words_
+};
+
+inline size_t lcsLengthBitpar(std::string_view a, std::string_view b) {
+    return LCSBitpar(b).length(a);
+}
+
+inline std::string lcsSeqBitpar(std::string_view a, std::string_view b) {
+    return LCSBitpar(b).seq(a);
+}
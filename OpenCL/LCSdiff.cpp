@@ -0,0 +1,361 @@
+#include <omp.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <random>
+#include <chrono>
+#include <ctime>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "LCSdiff.hpp"
+
+/*
+    diff -u on the token LCS (LCSdiff.hpp)
+    ./LCSdiff [-U n] fileA fileB    unified diff to stdout, exit 0: same, 1: different, 2: trouble
+    ./LCSdiff --bench [LINES]       2 synthetic files of ~LINES lines with scattered edits:
+                                    this vs GNU diff -u, timed; our hunks applied with patch & checked
+    Files are memory-mapped. Every line (with its '\n') is hashed in parallel, then numbered through 1
+    open-addressing table (memcmp on hash hits): equal lines <=> equal tokens.
+    Common prefix & suffix lines never reach the LCS. Memory: the 2 mappings + ~30 bytes per line.
+*/
+
+#define CONTEXT 3
+#define BENCH_LINES 1000000
+
+
+
+// ------ Input ------
+struct DiffFile {
+    std::string path;
+    const char* data = nullptr;
+    size_t len = 0;
+    struct timespec mtime = {};
+    std::vector<uint64_t> starts; // line k = [starts[k], starts[k + 1])
+    std::vector<uint32_t> tokens;
+
+    size_t lines() const { return starts.size() - 1; }
+    std::string_view line(size_t k) const { return std::string_view(data + starts[k], starts[k + 1] - starts[k]); }
+};
+
+static void die(const std::string& msg) {
+    std::cerr << msg << ": " << strerror(errno) << std::endl;
+    exit(2);
+}
+
+static void mapFile(DiffFile& f) {
+    int fd = open(f.path.c_str(), O_RDONLY);
+    if (fd < 0)
+        die("Cannot open " + f.path);
+    struct stat st;
+    fstat(fd, &st);
+    f.len = st.st_size;
+    f.mtime = st.st_mtim;
+    if (f.len) {
+        void* p = mmap(nullptr, f.len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED)
+            die("Cannot map " + f.path);
+        madvise(p, f.len, MADV_SEQUENTIAL);
+        f.data = (const char*)p;
+    }
+    close(fd);
+    f.starts.assign(1, 0);
+    for (const char* p = f.data; p && p < f.data + f.len;) {
+        const char* nl = (const char*)memchr(p, '\n', f.data + f.len - p);
+        p = nl ? nl + 1 : f.data + f.len;
+        f.starts.push_back(p - f.data);
+    }
+}
+
+static void unmapFile(DiffFile& f) {
+    if (f.data)
+        munmap((void*)f.data, f.len);
+    f.data = nullptr;
+}
+
+static uint64_t lineHash(std::string_view s) {
+    uint64_t h = 14695981039346656037ULL; // FNV-1a
+    for (unsigned char c : s)
+        h = (h ^ c) * 1099511628211ULL;
+    return h ^ (h >> 29);
+}
+
+// Token ids shared by both files, in order of first appearance
+static void tokenize(DiffFile& a, DiffFile& b) {
+    DiffFile* f[2] = { &a, &b };
+    std::vector<uint64_t> hashes[2];
+    for (int s = 0; s < 2; s++) {
+        hashes[s].resize(f[s]->lines());
+        #pragma omp parallel for schedule(static)
+        for (long k = 0; k < (long)f[s]->lines(); k++)
+            hashes[s][k] = lineHash(f[s]->line(k));
+    }
+    struct Slot {
+        uint64_t hash;
+        uint32_t token, file, line; // token 0: empty
+    };
+    size_t cap = 16;
+    while (cap < 2 * (a.lines() + b.lines()))
+        cap *= 2;
+    std::vector<Slot> table(cap, Slot { 0, 0, 0, 0 });
+    uint32_t next = 1;
+    for (int s = 0; s < 2; s++) {
+        f[s]->tokens.resize(f[s]->lines());
+        for (size_t k = 0; k < f[s]->lines(); k++) {
+            uint64_t h = hashes[s][k];
+            std::string_view l = f[s]->line(k);
+            for (size_t i = h & (cap - 1);; i = (i + 1) & (cap - 1)) {
+                Slot& e = table[i];
+                if (e.token == 0) {
+                    e = { h, next++, (uint32_t)s, (uint32_t)k };
+                    f[s]->tokens[k] = e.token;
+                    break;
+                }
+                if (e.hash == h && f[e.file]->line(e.line) == l) {
+                    f[s]->tokens[k] = e.token;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+
+// ------ Unified output ------
+static std::string stamp(const DiffFile& f) {
+    struct tm t;
+    localtime_r(&f.mtime.tv_sec, &t);
+    char date[64], zone[16], ns[16];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &t);
+    strftime(zone, sizeof(zone), "%z", &t);
+    snprintf(ns, sizeof(ns), ".%09ld", (long)f.mtime.tv_nsec);
+    return std::string(date) + ns + " " + zone;
+}
+
+static std::string range(size_t start, size_t count) {
+    if (count == 1)
+        return std::to_string(start + 1);
+    return std::to_string(count ? start + 1 : start) + "," + std::to_string(count);
+}
+
+static void emit(std::string& out, char tag, std::string_view l) {
+    out += tag;
+    out += l;
+    if (l.empty() || l.back() != '\n')
+        out += "\n\\ No newline at end of file\n";
+}
+
+// Hunks of the edit script (inA / inB: lines on the LCS), ctx lines of context. Returns #changed lines
+static size_t unified(const DiffFile& a, const DiffFile& b, const std::vector<char>& inA, const std::vector<char>& inB,
+                      size_t ctx, std::string& out, FILE* sink) {
+    struct Change {
+        size_t a0, a1, b0, b1; // A lines [a0, a1) replaced by B lines [b0, b1)
+    };
+    std::vector<Change> changes;
+    size_t i = 0, j = 0, m = a.lines(), n = b.lines(), changed = 0;
+    while (i < m || j < n) {
+        if ((i < m && !inA[i]) || (j < n && !inB[j])) {
+            Change c = { i, i, j, j };
+            while (i < m && !inA[i])
+                i++;
+            while (j < n && !inB[j])
+                j++;
+            c.a1 = i;
+            c.b1 = j;
+            changed += c.a1 - c.a0 + c.b1 - c.b0;
+            changes.push_back(c);
+        }
+        else {
+            i++;
+            j++;
+        }
+    }
+    if (changes.empty())
+        return 0;
+
+    out += "--- " + a.path + "\t" + stamp(a) + "\n+++ " + b.path + "\t" + stamp(b) + "\n";
+    for (size_t h = 0; h < changes.size();) {
+        size_t e = h; // hunk: changes[h..e], gaps of <= 2 ctx lines merged
+        while (e + 1 < changes.size() && changes[e + 1].a0 - changes[e].a1 <= 2 * ctx)
+            e++;
+        size_t a0 = changes[h].a0 - std::min(ctx, changes[h].a0);
+        size_t b0 = changes[h].b0 - (changes[h].a0 - a0);
+        size_t a1 = std::min(m, changes[e].a1 + ctx);
+        size_t b1 = changes[e].b1 + (a1 - changes[e].a1);
+        out += "@@ -" + range(a0, a1 - a0) + " +" + range(b0, b1 - b0) + " @@\n";
+        size_t at = a0;
+        for (size_t c = h; c <= e; c++) {
+            for (; at < changes[c].a0; at++)
+                emit(out, ' ', a.line(at));
+            for (size_t k = changes[c].a0; k < changes[c].a1; k++)
+                emit(out, '-', a.line(k));
+            for (size_t k = changes[c].b0; k < changes[c].b1; k++)
+                emit(out, '+', b.line(k));
+            at = changes[c].a1;
+        }
+        for (; at < a1; at++)
+            emit(out, ' ', a.line(at));
+        if (sink && out.size() > (1 << 20)) {
+            fwrite(out.data(), 1, out.size(), sink);
+            out.clear();
+        }
+        h = e + 1;
+    }
+    if (sink) {
+        fwrite(out.data(), 1, out.size(), sink);
+        out.clear();
+    }
+    return changed;
+}
+
+struct DiffStats {
+    size_t linesA = 0, linesB = 0, prefix = 0, suffix = 0, lcs = 0, changed = 0;
+    double tMap = 0, tTokens = 0, tLcs = 0, tOut = 0;
+};
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Unified diff of 2 files into out (or streamed to sink)
+static DiffStats diffFiles(const std::string& pathA, const std::string& pathB, size_t ctx, std::string& out, FILE* sink) {
+    DiffStats st;
+    DiffFile a, b;
+    a.path = pathA;
+    b.path = pathB;
+    auto start = std::chrono::steady_clock::now();
+    mapFile(a);
+    mapFile(b);
+    st.linesA = a.lines();
+    st.linesB = b.lines();
+    st.tMap = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    tokenize(a, b);
+    st.tTokens = seconds(start);
+
+    // Common prefix & suffix: matched without the LCS
+    start = std::chrono::steady_clock::now();
+    size_t m = a.lines(), n = b.lines();
+    while (st.prefix < std::min(m, n) && a.tokens[st.prefix] == b.tokens[st.prefix])
+        st.prefix++;
+    while (st.suffix < std::min(m, n) - st.prefix && a.tokens[m - 1 - st.suffix] == b.tokens[n - 1 - st.suffix])
+        st.suffix++;
+    std::vector<uint32_t> midA(a.tokens.begin() + st.prefix, a.tokens.end() - st.suffix);
+    std::vector<uint32_t> midB(b.tokens.begin() + st.prefix, b.tokens.end() - st.suffix);
+    std::vector<char> kA, kB;
+    st.lcs = st.prefix + st.suffix + lcsTokens(midA, midB, kA, kB);
+    std::vector<char> inA(m, 1), inB(n, 1);
+    std::copy(kA.begin(), kA.end(), inA.begin() + st.prefix);
+    std::copy(kB.begin(), kB.end(), inB.begin() + st.prefix);
+    st.tLcs = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    st.changed = unified(a, b, inA, inB, ctx, out, sink);
+    st.tOut = seconds(start);
+    unmapFile(a);
+    unmapFile(b);
+    return st;
+}
+
+
+
+// ------ Benchmark vs GNU diff ------
+// ~lines of code-like text (repeated braces & blank lines, unique statements) & an edited copy
+static void makePair(size_t lines, const std::string& pathA, const std::string& pathB) {
+    std::mt19937 rng(7);
+    const char* common[] = { "", "}", "    }", "    return 0;", "        break;", "#endif" };
+    std::vector<std::string> a(lines);
+    for (size_t k = 0; k < lines; k++)
+        a[k] = rng() % 4 == 0 ? common[rng() % 6] : "    x" + std::to_string(rng() % (lines * 4)) + " = f(" + std::to_string(k) + ");";
+    std::ofstream fa(pathA), fb(pathB);
+    for (const std::string& l : a)
+        fa << l << "\n";
+    // 1 edit per ~1000 lines: delete, insert or replace 1-8 lines
+    for (size_t k = 0; k < lines; k++) {
+        if (rng() % 1000 == 0) {
+            int kind = rng() % 3, len = 1 + rng() % 8;
+            for (int e = 0; kind != 0 && e < len; e++)
+                fb << "    y" << rng() << " = g();\n";
+            if (kind != 1) {
+                k += len - 1;
+                continue;
+            }
+        }
+        fb << a[k] << "\n";
+    }
+}
+
+static size_t countChanged(const std::string& path) {
+    std::ifstream in(path);
+    std::string l;
+    size_t c = 0;
+    while (std::getline(in, l))
+        c += (l[0] == '+' && l.compare(0, 4, "+++ ")) || (l[0] == '-' && l.compare(0, 4, "--- "));
+    return c;
+}
+
+static int bench(size_t lines) {
+    const char* dir = getenv("LCS_SCRATCH");
+    std::string base = std::string(dir ? dir : ".") + "/LCSdiff_";
+    std::string pa = base + "a.txt", pb = base + "b.txt", ours = base + "ours.patch", gnu = base + "gnu.patch";
+    makePair(lines, pa, pb);
+
+    std::string out;
+    FILE* f = fopen(ours.c_str(), "w");
+    if (!f)
+        die("Cannot create " + ours);
+    auto start = std::chrono::steady_clock::now();
+    DiffStats st = diffFiles(pa, pb, CONTEXT, out, f);
+    double tOurs = seconds(start);
+    fclose(f);
+
+    start = std::chrono::steady_clock::now();
+    int rc = system(("diff -u " + pa + " " + pb + " > " + gnu).c_str());
+    double tGnu = seconds(start);
+
+    std::cout << "Lines: " << st.linesA << " vs " << st.linesB << ", common prefix " << st.prefix << ", suffix "
+              << st.suffix << ", LCS " << st.lcs << "\n";
+    std::cout << "LCSdiff:  " << tOurs << " s (map " << st.tMap << ", tokens " << st.tTokens << ", LCS " << st.tLcs
+              << ", hunks " << st.tOut << "), " << st.changed << " changed lines\n";
+    if (rc == -1 || WEXITSTATUS(rc) > 1)
+        std::cout << "GNU diff: not available\n";
+    else
+        std::cout << "GNU diff: " << tGnu << " s, " << countChanged(gnu) << " changed lines\n";
+
+    // Our patch turns A into B
+    std::string patched = base + "patched.txt";
+    rc = system(("patch -s -o " + patched + " " + pa + " < " + ours + " && cmp -s " + patched + " " + pb).c_str());
+    std::cout << "patch A + LCSdiff = B: " << (rc == 0 ? "yes" : "NO") << std::endl;
+    for (const std::string& p : { pa, pb, ours, gnu, patched })
+        remove(p.c_str());
+    return rc != 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--bench")
+        return bench(args.size() > 1 ? atol(args[1].c_str()) : BENCH_LINES);
+
+    size_t ctx = CONTEXT;
+    if (args.size() >= 2 && args[0] == "-U") {
+        ctx = atol(args[1].c_str());
+        args.erase(args.begin(), args.begin() + 2);
+    }
+    if (args.size() != 2) {
+        std::cout << " Usage: ./LCSdiff [-U n] fileA fileB\n        ./LCSdiff --bench [LINES]\n";
+        return 2;
+    }
+    std::string out;
+    DiffStats st = diffFiles(args[0], args[1], ctx, out, stdout);
+    return st.changed != 0;
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <cmath>
+#include <cstdint>
+#include "LCSbitpar.hpp"
+
+/*
+    LCS of 2 token sequences (e.g. lines hashed to ids), exact, in O(m + n) memory
+    Every subproblem: common prefix & suffix matched off first, then split at a point of an optimal path
+    and the 2 halves solved independently (on separate threads for the first log2(#threads) levels).
+    - Split by Myers' O(ND) middle snake while the edit distance D is small: cost ~D^2 + m + n,
+      so files with few changes cost ~ their length, whatever their size
+    - Past D ~ sqrt(mn / 32) the bit-parallel Hirschberg split is cheaper (2 x m x n / 64 word ops):
+      A split at mid, forward & backward last rows of the bit-parallel engine (match masks built per row
+      from b's sorted (token, column) list, rows whose token is absent from b skipped), on 2 threads
+    - Small subproblems: plain table & traceback
+    Tokens absent from the other sequence cannot be matched and are dropped up front.
+*/
+
+#define LCS_DIFF_BASE 4096    // subproblems with <= this many cells use the plain table
+#define LCS_DIFF_MYERS_MIN 64 // Myers' search always runs to at least this D
+
+
+
+// Last row: row[j] = LCS(a, b[0, j)), rev: of the reversed sequences
+inline void lcsTokenRow(const uint32_t* a, size_t m, const uint32_t* b, size_t n, bool rev, std::vector<int>& row) {
+    std::vector<std::pair<uint32_t, uint32_t>> occ(n); // (token, column), sorted
+    for (size_t j = 0; j < n; j++)
+        occ[j] = { b[rev ? n - 1 - j : j], (uint32_t)j };
+    std::sort(occ.begin(), occ.end());
+    size_t words = (n + 63) / 64;
+    std::vector<uint64_t> v(words, ~0ULL), pm(words, 0);
+    for (size_t i = 0; i < m; i++) {
+        uint32_t t = a[rev ? m - 1 - i : i];
+        auto lo = std::lower_bound(occ.begin(), occ.end(), std::make_pair(t, 0u));
+        auto hi = std::upper_bound(lo, occ.end(), std::make_pair(t, UINT32_MAX));
+        if (lo == hi)
+            continue;
+        for (auto p = lo; p != hi; ++p)
+            pm[p->second / 64] |= 1ULL << (p->second % 64);
+        bitparStep(v.data(), v.data(), pm.data(), words);
+        for (auto p = lo; p != hi; ++p)
+            pm[p->second / 64] = 0;
+    }
+    row.resize(n + 1);
+    row[0] = 0;
+    for (size_t j = 0; j < n; j++)
+        row[j + 1] = row[j] + !((v[j / 64] >> (j % 64)) & 1);
+}
+
+// Small subproblem: plain table + traceback
+inline void lcsTokenTable(const uint32_t* a, size_t m, const uint32_t* b, size_t n, char* inA, char* inB) {
+    std::vector<int> tab((m + 1) * (n + 1), 0);
+    for (size_t i = 1; i <= m; i++) {
+        for (size_t j = 1; j <= n; j++) {
+            size_t idx = i * (n + 1) + j;
+            if (a[i - 1] == b[j - 1])
+                tab[idx] = tab[idx - (n + 2)] + 1;
+            else
+                tab[idx] = std::max(tab[idx - 1], tab[idx - (n + 1)]);
+        }
+    }
+    size_t r_trav = m;
+    size_t c_trav = n;
+    while (r_trav != 0 && c_trav != 0) {
+        size_t idx = r_trav * (n + 1) + c_trav;
+        if (a[r_trav - 1] == b[c_trav - 1]) {
+            inA[--r_trav] = 1;
+            inB[--c_trav] = 1;
+        }
+        else if (tab[idx - (n + 1)] >= tab[idx - 1])
+            r_trav -= 1;
+        else
+            c_trav -= 1;
+    }
+}
+
+// Myers' middle snake: (sx, sy) on a shortest edit path of a vs b. false if D > maxD (or no common token)
+inline bool lcsMyersSplit(const uint32_t* a, long m, const uint32_t* b, long n, long maxD, long& sx, long& sy) {
+    long maxd = (m + n + 1) / 2;
+    long off = maxd, len = 2 * maxd + 2;
+    std::vector<long> v1(len, -1), v2(len, -1); // furthest x per diagonal k = x - y, forward / from the end
+    v1[off + 1] = 0;
+    v2[off + 1] = 0;
+    long delta = m - n;
+    bool front = delta % 2 != 0; // odd: paths meet during a forward pass
+    long k1s = 0, k1e = 0, k2s = 0, k2e = 0;
+    for (long d = 0; d < std::min(maxd, maxD + 1); d++) {
+        for (long k1 = -d + k1s; k1 <= d - k1e; k1 += 2) {
+            long ko = off + k1;
+            long x1 = (k1 == -d || (k1 != d && v1[ko - 1] < v1[ko + 1])) ? v1[ko + 1] : v1[ko - 1] + 1;
+            long y1 = x1 - k1;
+            while (x1 < m && y1 < n && a[x1] == b[y1]) {
+                x1++;
+                y1++;
+            }
+            v1[ko] = x1;
+            if (x1 > m)
+                k1e += 2;
+            else if (y1 > n)
+                k1s += 2;
+            else if (front) {
+                long k2o = off + delta - k1;
+                if (k2o >= 0 && k2o < len && v2[k2o] != -1 && x1 >= m - v2[k2o]) {
+                    sx = x1;
+                    sy = y1;
+                    return true;
+                }
+            }
+        }
+        for (long k2 = -d + k2s; k2 <= d - k2e; k2 += 2) {
+            long ko = off + k2;
+            long x2 = (k2 == -d || (k2 != d && v2[ko - 1] < v2[ko + 1])) ? v2[ko + 1] : v2[ko - 1] + 1;
+            long y2 = x2 - k2;
+            while (x2 < m && y2 < n && a[m - x2 - 1] == b[n - y2 - 1]) {
+                x2++;
+                y2++;
+            }
+            v2[ko] = x2;
+            if (x2 > m)
+                k2e += 2;
+            else if (y2 > n)
+                k2s += 2;
+            else if (!front) {
+                long k1o = off + delta - k2;
+                if (k1o >= 0 && k1o < len && v1[k1o] != -1 && v1[k1o] >= m - x2) {
+                    sx = v1[k1o];
+                    sy = off + sx - k1o;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// spawn: #levels that still hand one half to a new thread
+inline void lcsTokensRec(const uint32_t* a, size_t m, const uint32_t* b, size_t n, char* inA, char* inB, int spawn) {
+    size_t p = 0;
+    while (p < m && p < n && a[p] == b[p]) {
+        inA[p] = inB[p] = 1;
+        p++;
+    }
+    a += p;
+    b += p;
+    inA += p;
+    inB += p;
+    m -= p;
+    n -= p;
+    while (m > 0 && n > 0 && a[m - 1] == b[n - 1]) {
+        inA[--m] = 1;
+        inB[--n] = 1;
+    }
+    if (m == 0 || n == 0)
+        return;
+    if (m == 1 || n == 1) {
+        const uint32_t* s = m == 1 ? b : a;
+        size_t len = m == 1 ? n : m;
+        uint32_t t = m == 1 ? a[0] : b[0];
+        size_t k = std::find(s, s + len, t) - s;
+        if (k < len) {
+            (m == 1 ? inB : inA)[k] = 1;
+            (m == 1 ? inA : inB)[0] = 1;
+        }
+        return;
+    }
+    if ((m + 1) * (n + 1) <= LCS_DIFF_BASE) {
+        lcsTokenTable(a, m, b, n, inA, inB);
+        return;
+    }
+
+    long sx = 0, sy = 0;
+    long maxD = std::max<long>(LCS_DIFF_MYERS_MIN, std::sqrt((double)m * n / 32));
+    if (!lcsMyersSplit(a, m, b, n, maxD, sx, sy) || sx + sy == 0 || (size_t)(sx + sy) == m + n) {
+        size_t mid = m / 2;
+        std::vector<int> fwd, bwd;
+        if (spawn > 0) {
+            auto f = std::async(std::launch::async, [&] { lcsTokenRow(a, mid, b, n, false, fwd); });
+            lcsTokenRow(a + mid, m - mid, b, n, true, bwd);
+            f.get();
+        }
+        else {
+            lcsTokenRow(a, mid, b, n, false, fwd);
+            lcsTokenRow(a + mid, m - mid, b, n, true, bwd);
+        }
+        int best = -1;
+        for (size_t j = 0; j <= n; j++)
+            if (fwd[j] + bwd[n - j] > best) {
+                best = fwd[j] + bwd[n - j];
+                sy = j;
+            }
+        sx = mid;
+    }
+
+    if (spawn > 0) {
+        auto left = std::async(std::launch::async, lcsTokensRec, a, sx, b, sy, inA, inB, spawn - 1);
+        lcsTokensRec(a + sx, m - sx, b + sy, n - sy, inA + sx, inB + sy, spawn - 1);
+        left.get();
+    }
+    else {
+        lcsTokensRec(a, sx, b, sy, inA, inB, 0);
+        lcsTokensRec(a + sx, m - sx, b + sy, n - sy, inA + sx, inB + sy, 0);
+    }
+}
+
+// inA[i] / inB[j] = 1 on the tokens of 1 LCS. Tokens: dense ids (memory ~ the largest). Returns the LCS length
+inline size_t lcsTokens(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, std::vector<char>& inA,
+                        std::vector<char>& inB) {
+    inA.assign(a.size(), 0);
+    inB.assign(b.size(), 0);
+    uint32_t top = 0;
+    for (uint32_t t : a)
+        top = std::max(top, t);
+    for (uint32_t t : b)
+        top = std::max(top, t);
+    std::vector<char> seen(top + 1, 0); // bit 0: in a, bit 1: in b
+    for (uint32_t t : a)
+        seen[t] |= 1;
+    for (uint32_t t : b)
+        seen[t] |= 2;
+
+    // Matchable tokens only, with their positions
+    std::vector<uint32_t> ca, cb;
+    std::vector<size_t> ia, ib;
+    for (size_t i = 0; i < a.size(); i++)
+        if (seen[a[i]] == 3) {
+            ca.push_back(a[i]);
+            ia.push_back(i);
+        }
+    for (size_t j = 0; j < b.size(); j++)
+        if (seen[b[j]] == 3) {
+            cb.push_back(b[j]);
+            ib.push_back(j);
+        }
+    std::vector<char>().swap(seen);
+
+    std::vector<char> ka(ca.size(), 0), kb(cb.size(), 0);
+    int spawn = 0;
+    for (unsigned t = std::max(1u, std::thread::hardware_concurrency()); t > 1; t /= 2)
+        spawn++;
+    lcsTokensRec(ca.data(), ca.size(), cb.data(), cb.size(), ka.data(), kb.data(), spawn);
+
+    size_t len = 0;
+    for (size_t i = 0; i < ka.size(); i++)
+        if (ka[i]) {
+            inA[ia[i]] = 1;
+            len++;
+        }
+    for (size_t j = 0; j < kb.size(); j++)
+        if (kb[j])
+            inB[ib[j]] = 1;
+    return len;
+}
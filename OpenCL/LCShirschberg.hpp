@@ -0,0 +1,145 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+
+/*
+    Hirschberg LCS: recovers the subsequence in O(m + n) memory instead of the (m+1) x (n+1) table.
+    Split A at mid, score A[0, mid) forward & A[mid, m) backward against B (1 row each),
+    the column k maximising fwd[k] + bwd[n - k] is where the LCS path crosses row mid.
+    The 2 halves (A[0, mid), B[0, k)) and (A[mid, m), B[k, n)) are independent -> run on separate threads.
+
+    Memory budget (MB) for the full table: env LCS_MEM_BUDGET, default LCS_MEM_BUDGET_DEFAULT
+*/
+
+#define LCS_MEM_BUDGET_DEFAULT 1024
+#define LCS_HIRSCH_BASE 4096 // subproblems with <= this many cells use the plain table
+
+
+
+inline size_t lcsMemBudget() {
+    const char* env = std::getenv("LCS_MEM_BUDGET");
+    size_t mb = LCS_MEM_BUDGET_DEFAULT;
+    if (env) {
+        char* end;
+        size_t v = std::strtoull(env, &end, 10);
+        if (end != env) {
+            mb = v;
+        } else {
+            static std::atomic<bool> warned{ false }; // called per table size check, from any thread: warn once
+            if (!warned.exchange(true))
+                std::cerr << "Warning: LCS_MEM_BUDGET=" << env << " is not a number of MB, using "
+                          << LCS_MEM_BUDGET_DEFAULT << "." << std::endl;
+        }
+    }
+    return mb * 1024 * 1024;
+}
+
+// Full (m+1) x (n+1) table needed?
+inline bool lcsFitsBudget(size_t m, size_t n) {
+    return (m + 1) * (n + 1) * sizeof(int) <= lcsMemBudget();
+}
+
+// Last DP row of a vs b: row[j] = LCS(a, b[0, j)). rev: score reversed a & b
+inline void lcsLastRow(std::string_view a, std::string_view b, bool rev, std::vector<int>& row) {
+    int m = a.size();
+    int n = b.size();
+    row.assign(n + 1, 0);
+    for (int i = 1; i <= m; i++) {
+        char ai = rev ? a[m - i] : a[i - 1];
+        int diag = 0; // row[j - 1] of the previous row
+        for (int j = 1; j <= n; j++) {
+            char bj = rev ? b[n - j] : b[j - 1];
+            int top = row[j];
+            row[j] = (ai == bj) ? diag + 1 : std::max(top, row[j - 1]);
+            diag = top;
+        }
+    }
+}
+
+// Small subproblem: plain table + traceback
+inline std::string lcsTable(std::string_view a, std::string_view b) {
+    int m = a.size();
+    int n = b.size();
+    std::vector<int> tab((m + 1) * (n + 1), 0);
+    for (int i = 1; i <= m; i++) {
+        for (int j = 1; j <= n; j++) {
+            int idx = i * (n + 1) + j;
+            if (a[i - 1] == b[j - 1])
+                tab[idx] = tab[idx - (n + 2)] + 1;
+            else
+                tab[idx] = std::max(tab[idx - 1], tab[idx - (n + 1)]);
+        }
+    }
+
+    std::string seq;
+    int r_trav = m;
+    int c_trav = n;
+    while (r_trav != 0 && c_trav != 0) {
+        int idx = r_trav * (n + 1) + c_trav;
+        if (a[r_trav - 1] == b[c_trav - 1]) {
+            seq += a[r_trav - 1];
+            r_trav -= 1;
+            c_trav -= 1;
+        }
+        else if (tab[idx - (n + 1)] >= tab[idx - 1])
+            r_trav -= 1;
+        else
+            c_trav -= 1;
+    }
+    std::reverse(seq.begin(), seq.end());
+    return seq;
+}
+
+// spawn: #levels that still hand one half to a new thread (log2 #threads)
+inline std::string lcsHirschbergRec(std::string_view a, std::string_view b, int spawn) {
+    size_t m = a.size();
+    size_t n = b.size();
+    if (m == 0 || n == 0)
+        return "";
+    if ((m + 1) * (n + 1) <= LCS_HIRSCH_BASE || m == 1)
+        return lcsTable(a, b);
+
+    size_t mid = m / 2;
+    std::vector<int> fwd, bwd;
+    if (spawn > 0) {
+        auto f = std::async(std::launch::async, [&] { lcsLastRow(a.substr(0, mid), b, false, fwd); });
+        lcsLastRow(a.substr(mid), b, true, bwd);
+        f.get();
+    }
+    else {
+        lcsLastRow(a.substr(0, mid), b, false, fwd);
+        lcsLastRow(a.substr(mid), b, true, bwd);
+    }
+
+    size_t k = 0;
+    int best = -1;
+    for (size_t j = 0; j <= n; j++) {
+        if (fwd[j] + bwd[n - j] > best) {
+            best = fwd[j] + bwd[n - j];
+            k = j;
+        }
+    }
+    std::vector<int>().swap(fwd);
+    std::vector<int>().swap(bwd);
+
+    if (spawn > 0) {
+        auto left = std::async(std::launch::async, lcsHirschbergRec, a.substr(0, mid), b.substr(0, k), spawn - 1);
+        std::string right = lcsHirschbergRec(a.substr(mid), b.substr(k), spawn - 1);
+        return left.get() + right;
+    }
+    return lcsHirschbergRec(a.substr(0, mid), b.substr(0, k), 0) + lcsHirschbergRec(a.substr(mid), b.substr(k), 0);
+}
+
+inline std::string lcsHirschberg(std::string_view a, std::string_view b) {
+    int spawn = 0;
+    for (unsigned t = std::max(1u, std::thread::hardware_concurrency()); t > 1; t /= 2)
+        spawn++;
+    return lcsHirschbergRec(a, b, spawn);
+}
@@ -1,8 +1,15 @@
 #include <iostream>
 #include <vector>
 #include <iomanip>
+#include "LCShirschberg.hpp"
+
+#define LCS_PRINT_MAX 32 // table printed only when m, n <= LCS_PRINT_MAX
+
+std::string lcs(const std::string& a, const std::string& b, int m, int n) {
+    // Table over LCS_MEM_BUDGET: linear-space mode
+    if (!lcsFitsBudget(m, n))
+        return lcsHirschberg(a, b);
 
-std::string lcs(std::string a, std::string b, int m, int n) {
     std::vector<std::vector<int>> tab(m + 1, std::vector<int>(n + 1));
     // ------ padding ------
     for (int i = 0; i <= m; i++) {
@@ -29,7 +36,7 @@ std::string lcs(std::string a, std::string b, int m, int n) {
         }
     }
 
-    for (int i = 0; i < tab.size(); i++) {
+    for (int i = 0; m <= LCS_PRINT_MAX && n <= LCS_PRINT_MAX && i < tab.size(); i++) {
         for (int j = 0; j < tab[i].size(); j++)
             std::cout << tab[i][j] << std::setw(2);
         std::cout << "\n";
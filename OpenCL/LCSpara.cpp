@@ -2,57 +2,62 @@
 #include <iostream>
 #include <iomanip>
 #include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include "LCShirschberg.hpp"
+#include "LCSpara.hpp"
+
+// Traceback: walk tile by tile from the last cell, recomputing each tile on host from its stored boundary
+std::string lcsSeq(const std::string& a, const std::string& b,
+                   const std::vector<int>& horiz, const std::vector<int>& vert, int T) {
+    int m = a.size();
+    int n = b.size();
+    std::vector<int> tab((T + 1) * (T + 1));
 
-const char* kern = R"(
-__kernel void lcs_kern(__global const char* a, __global const char* b, const int m, const int n, __global int* tab) {
-    int i = get_global_id(0) + 1;
-    int j = get_global_id(1) + 1;
-
-    int idx = i * (n + 1) + j;
-    int left = i * (n + 1) + j - 1;
-    int diag = (i - 1) * (n + 1) + j - 1;
-    int top  = (i - 1) * (n + 1) + j;
-    
-    if (b[j - 1] == a[i - 1])
-        tab[idx] = tab[diag] + 1;
-    else
-        tab[idx] = max(tab[left], tab[top]);    
-}
-)";
-
-
-
-
-
-std::vector<std::vector<int>> lcsPadding(int m, int n, std::vector<std::vector<int>> tab) {
-    for (int i = 0; i <= m; i++) {
-        for (int j = 0; j <= n; j++)
-            tab[i][j] = -1;
-    }
-
-    for (int i = 0; i <= m; i++)
-        tab[i][0] = 0;
-    for (int i = 0; i <= n; i++)
-        tab[0][i] = 0;
-    return tab;
-}
-
-std::string lcsSeq(std::string a, std::string b, std::vector<std::vector<int>> tab) {
-    // Table traversal from the very last elem
     std::string seq;
-    int r_trav = a.size();
-    int c_trav = b.size(); 
+    int r_trav = m;
+    int c_trav = n;
     while (r_trav != 0 && c_trav != 0) {
-        if (tab[r_trav][c_trav] > tab[r_trav - 1][c_trav - 1]) {
-            seq += a[r_trav - 1];
-            r_trav -= 1;
-            c_trav -= 1;
+        int ti = (r_trav - 1) / T;
+        int tj = (c_trav - 1) / T;
+        int i0 = ti * T;
+        int j0 = tj * T;
+        int h = std::min(T, m - i0);
+        int w = std::min(T, n - j0);
+
+        for (int c = 0; c <= w; c++)
+            tab[c] = horiz[(size_t)ti * (n + 1) + j0 + c];
+        for (int r = 1; r <= h; r++)
+            tab[r * (T + 1)] = vert[(size_t)tj * (m + 1) + i0 + r];
+        for (int r = 1; r <= h; r++) {
+            for (int c = 1; c <= w; c++) {
+                int idx = r * (T + 1) + c;
+                if (a[i0 + r - 1] == b[j0 + c - 1])
+                    tab[idx] = tab[idx - (T + 2)] + 1;
+                else
+                    tab[idx] = std::max(tab[idx - 1], tab[idx - (T + 1)]);
+            }
         }
 
-        else if (tab[r_trav][c_trav] == tab[r_trav - 1][c_trav])
-            r_trav -= 1;
-        else if (tab[r_trav][c_trav] == tab[r_trav][c_trav -1])
-            c_trav -= 1;
+        // Trace until the path leaves the tile through its top or left edge
+        int r = r_trav - i0;
+        int c = c_trav - j0;
+        while (r != 0 && c != 0) {
+            int idx = r * (T + 1) + c;
+            if (a[i0 + r - 1] == b[j0 + c - 1]) {
+                seq += a[i0 + r - 1];
+                r -= 1;
+                c -= 1;
+            }
+            else if (tab[idx - (T + 1)] >= tab[idx - 1])
+                r -= 1;
+            else
+                c -= 1;
+        }
+        r_trav = i0 + r;
+        c_trav = j0 + c;
     }
     std::reverse(seq.begin(), seq.end());
     return seq;
@@ -60,33 +65,21 @@ std::string lcsSeq(std::string a, std::string b, std::vector<std::vector<int>> t
 
 
 
-int main() {
+// ./LCSpara [multi]   multi: the length also by LCSMulti (every device & NUMA sub-device)
+int main(int argc, char** argv) {
+    bool multi = argc > 1 && std::string(argv[1]) == "multi";
 
     // ------ Sys env ------
-    std::vector<cl::Platform> all_platforms;
-    cl::Platform::get(&all_platforms);
-    
-    cl::Platform plat = all_platforms[0];
-
-    std::vector<cl::Device> all_devices;
-    plat.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
-    if (all_devices.size() == 0) {
-        std::cout << " No devices found.\n";
-        exit(1);
-    }
-
-    cl::Device dev = all_devices[0];
-
+    // Device by policy, context, queue & buffer pool: clRuntime.hpp
+    // Kernel, buffers & the per-diagonal launches: LCSpara.hpp
+    ClRuntime& rt = ClRuntime::get();
+    LCSWavefront wave(rt);
+    printCacheStat(wave.buildStat());
 
 
-    // ------ Create context & sources ------
-
-    // Context: inter-device mem. share
-    cl::Context contxt({ dev });
-    cl::Program::Sources src;
 
     // ------ Input ------
-    // Host 
+    // Host
     std::string A;
     std::string B;
 
@@ -96,96 +89,50 @@ int main() {
     std::cin >> B;
     int m = A.size();
     int n = B.size();
-
-    const char* A_h = A.c_str();
-    const char* B_h = B.c_str();
-
-    std::vector<std::vector<int>> tabVec(m + 1, std::vector<int>(n + 1));
-    tabVec = lcsPadding(m, n, tabVec);
-
-    int* tab = (int*) malloc(sizeof(int) * ((m + 1) * (n + 1)));
-    for (int i = 0; i <= m; i++) {
-        for (int j = 0; j <= n; j++) {
-            tab[i * (n + 1) + j] = tabVec[i][j];
-        }
+    if (m == 0 || n == 0) {
+        std::cout << "LCS length: 0" << std::endl;
+        return 0;
     }
 
-    // ------ Buffer setup ------
-
-    // Buffer: mem allo. to the dev.
-    // Image: 2D/3D buffer
-    cl::Buffer buf_A(contxt, CL_MEM_READ_ONLY, sizeof(char) * m);
-    cl::Buffer buf_B(contxt, CL_MEM_READ_ONLY, sizeof(char) * n);
-    cl::Buffer buf_m(contxt, CL_MEM_READ_ONLY, sizeof(int));
-    cl::Buffer buf_n(contxt, CL_MEM_READ_ONLY, sizeof(int));
-
-    cl::Buffer buf_tab(contxt, CL_MEM_READ_WRITE, sizeof(int) * ((m + 1) * (n + 1)) );
-    // CL_MEM_READ(WRITE)_ONLY / CL_MEM_READ_WRITE
-
-
-    // ------ Command (Task) Queue ------
-    // Queue: push cmd onto Dev, ~= CUDA streams
-    // queue for each dev
-    cl::CommandQueue qu(contxt, dev);
-    // Read/Write/Map/Copy
-    // blocking = CL_TRUE for sync
-    qu.enqueueWriteBuffer(buf_A, CL_TRUE, 0, sizeof(char) * m, A_h);
-    qu.enqueueWriteBuffer(buf_B, CL_TRUE, 0, sizeof(char) * n, B_h);
-    qu.enqueueWriteBuffer(buf_m, CL_TRUE, 0, sizeof(int), &m);
-    qu.enqueueWriteBuffer(buf_n, CL_TRUE, 0, sizeof(int), &n);
-
-    qu.enqueueWriteBuffer(buf_tab, CL_TRUE, 0, sizeof(int) * ((m + 1) * (n + 1)), tab);
-
-    // ------ Run kernel in source ------
-
-    // push kern to the source code
-    src.push_back({ kern, strlen(kern) });
-    // OpenCL prog: link src to context
-    cl::Program prog(contxt, src);
-
-    // check build
-    if (prog.build({ dev }) != CL_SUCCESS) {
-        std::cout << " Error building: " << prog.getBuildInfo<CL_PROGRAM_BUILD_LOG>(dev) << std::endl;
-        exit(1);
+    // Tile boundaries over LCS_MEM_BUDGET: linear-space mode on host threads
+    if (LCSWavefront::boundaryBytes(m, n) > lcsMemBudget()) {
+        std::cout << "Boundaries exceed LCS_MEM_BUDGET, using Hirschberg on host" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        std::string LCS = lcsHirschberg(A, B);
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "LCS length: " << LCS.size() << std::endl;
+        std::cout << "Host time (s): " << t << std::endl;
+        if (LCS.size() <= 1000)
+            std::cout << "The LCS: " << LCS << std::endl;
+        return 0;
     }
 
-    // ------ Create kernel for exec ------
-    cl::compatibility::make_kernel<cl::Buffer, cl::Buffer, cl::Buffer, cl::Buffer, cl::Buffer> lcs_kern(cl::Kernel(prog, "lcs_kern"));
-    // *N.B.* Kernel name must match the function name
-    // https://github.khronos.org/OpenCL-CLHPP/structcl_1_1compatibility_1_1make__kernel.html
-
-    cl::NDRange global(m, n);
-    
-    // Event
-    //cl::Event erLcsKern;
-
-    lcs_kern(cl::EnqueueArgs(qu, global),
-        buf_A, buf_B, buf_m, buf_n, buf_tab).wait();
-    // .wait() or .waitForEvents( {ekern0} )
-
-    //cl_ulong start = eLcsKern.getProfilingInfo<CL_PROFILING_COMMAND_START>();
-    //cl_ulong end = eLcsKern.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+    // ------ Run kernel ------
+    int len = wave.run(A, B);
+    double t = wave.seconds();
 
     // Read data from dev
-    qu.finish();
-    qu.enqueueReadBuffer(buf_tab, CL_TRUE, 0, sizeof(int) * ((m + 1) * (n + 1)), tab);
-
-    std::string buildLog = prog.getBuildInfo<CL_PROGRAM_BUILD_LOG>(dev);
-
-    for (int i = 0; i <= m; i++) {
-        for (int j = 0; j <= n; j++)
-            tabVec[i][j] = tab[i * (n + 1) + j];
-    }
-
-    for (int i = 0; i < tabVec.size(); i++) {
-        for (int j = 0; j < tabVec[i].size(); j++)
-            std::cout << tabVec[i][j] << std::setw(2);
-        std::cout << "\n";
+    std::vector<int> horiz;
+    std::vector<int> vert;
+    wave.boundaries(horiz, vert);
+
+    std::cout << "LCS length: " << len << std::endl;
+    std::cout << "Kernel time (s): " << t << std::endl;
+    std::cout << "Throughput (cells/s): " << std::scientific << std::setprecision(3)
+              << (double)m * n / t << std::defaultfloat << std::endl;
+
+    if (multi) {
+        LCSMulti lm;
+        int lenMulti = lm.run(A, B);
+        for (size_t k = 0; k + 1 < lm.strips().size(); k++)
+            std::cout << "  " << lm.device(k).name() << ": B[" << lm.strips()[k] << ", " << lm.strips()[k + 1] << ")" << std::endl;
+        std::cout << "Multi-device LCS length: " << lenMulti << (lenMulti == len ? "" : " (MISMATCH)") << ", "
+                  << lm.strips().size() - 1 << " device(s), time (s): " << lm.seconds() << std::endl;
     }
 
-    std::string LCS = lcsSeq(A, B, tabVec);
-    std::cout << "The LCS: " << LCS << std::endl;
+    std::string LCS = lcsSeq(A, B, horiz, vert, TILE);
+    if (LCS.size() <= 1000)
+        std::cout << "The LCS: " << LCS << std::endl;
 
     return 0;
 }
-
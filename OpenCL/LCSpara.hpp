@@ -0,0 +1,308 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <cstdlib>
+#include "clRuntime.hpp"
+
+#define TILE 64
+
+/*
+    Wavefront LCS
+    The (m+1) x (n+1) table is cut into TILE x TILE tiles. Tile (ti, tj) needs its top & left neighbours,
+    so all tiles on one anti-diagonal (ti + tj = d) are independent: 1 launch per anti-diagonal,
+    1 work-group per tile. Inside the work-group the tile is swept again by anti-diagonals in __local mem.
+
+    Only tile boundaries touch global mem:
+    horiz[ti][0..n]: table row ti*TILE     ((tilesI + 1) rows)
+    vert [tj][0..m]: table column tj*TILE  ((tilesJ + 1) columns)
+    Row 0 / column 0 of the table are the zero padding.
+    A tile's corner (i0, j0) is read from vert, so column 0 may also hold a left neighbour's values (LCSMulti).
+
+    LCSMulti: B cut into column strips over deviceSet() (devices & NUMA sub-devices), see below.
+*/
+inline const char* const lcsWaveKern = R"(
+__kernel void lcs_kern(__global const char* a, __global const char* b, const int m, const int n,
+                       const int diag, const int tiStart, __global int* horiz, __global int* vert) {
+    __local int tab[(TILE + 1) * (TILE + 1)];
+    __local char b_l[TILE];
+
+    int ti = tiStart + get_group_id(0);
+    int tj = diag - ti;
+    int k = get_local_id(0); // work-item k owns row k of the tile
+
+    int i0 = ti * TILE;
+    int j0 = tj * TILE;
+    int h = min(TILE, m - i0);
+    int w = min(TILE, n - j0);
+
+    // ------ Load tile boundary ------
+    if (k == 0)
+        tab[0] = vert[(long)tj * (m + 1) + i0]; // corner
+    tab[k + 1] = (k < w) ? horiz[(long)ti * (n + 1) + j0 + k + 1] : 0;
+    tab[(k + 1) * (TILE + 1)] = (k < h) ? vert[(long)tj * (m + 1) + i0 + k + 1] : 0;
+    b_l[k] = (k < w) ? b[j0 + k] : 0;
+    char a_k = (k < h) ? a[i0 + k] : 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // ------ Wavefront inside the tile ------
+    // h + w - 1 is uniform over the work-group, so every work-item hits every barrier
+    for (int s = 0; s < h + w - 1; s++) {
+        int c = s - k;
+        if (k < h && c >= 0 && c < w) {
+            int idx = (k + 1) * (TILE + 1) + c + 1;
+            if (a_k == b_l[c])
+                tab[idx] = tab[idx - (TILE + 2)] + 1; // diag
+            else
+                tab[idx] = max(tab[idx - 1], tab[idx - (TILE + 1)]); // left, top
+        }
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    // ------ Write back bottom row & right column only ------
+    if (k < w)
+        horiz[(long)(ti + 1) * (n + 1) + j0 + k + 1] = tab[h * (TILE + 1) + k + 1];
+    if (k < h)
+        vert[(long)(tj + 1) * (m + 1) + i0 + k + 1] = tab[(k + 1) * (TILE + 1) + w];
+}
+)";
+
+
+
+// ------ Device wavefront ------
+// Program built once (binary cache across runs), buffers from the runtime's pool:
+// LCSpara.cpp runs it once, the benchmark suite many times per size
+class LCSWavefront {
+public:
+    explicit LCSWavefront(ClRuntime& rt = ClRuntime::get())
+        : rt_(rt), qu_(rt.queue()) {
+        if (rt_.device().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() < TILE) {
+            std::cout << " Device max work-group size < TILE (" << TILE << ").\n";
+            exit(1);
+        }
+        // OpenCL prog: built from lcsWaveKern once, then loaded from the binary cache
+        prog_ = rt_.program(lcsWaveKern, "-D TILE=" + std::to_string(TILE), &buildStat_);
+        // *N.B.* Kernel name must match the function name
+        // https://github.khronos.org/OpenCL-CLHPP/structcl_1_1compatibility_1_1make__kernel.html
+        kern_ = cl::Kernel(prog_, "lcs_kern");
+    }
+
+    // Bytes of the tile boundaries for an m x n table
+    static size_t boundaryBytes(int m, int n) {
+        size_t tilesI = (m + TILE - 1) / TILE;
+        size_t tilesJ = (n + TILE - 1) / TILE;
+        return ((tilesI + 1) * (n + 1) + (tilesJ + 1) * (m + 1)) * sizeof(int);
+    }
+
+    // LCS length of A x B (both non-empty), tile boundaries left on the device. Kernel time: seconds()
+    int run(const std::string& A, const std::string& B) {
+        m_ = A.size();
+        n_ = B.size();
+        int tilesI = (m_ + TILE - 1) / TILE;
+        int tilesJ = (n_ + TILE - 1) / TILE;
+        horizSize_ = (size_t)(tilesI + 1) * (n_ + 1);
+        vertSize_ = (size_t)(tilesJ + 1) * (m_ + 1);
+
+        reserve(buf_A_, sizeof(char) * m_, CL_MEM_READ_ONLY);
+        reserve(buf_B_, sizeof(char) * n_, CL_MEM_READ_ONLY);
+        reserve(buf_horiz_, sizeof(int) * horizSize_, CL_MEM_READ_WRITE);
+        reserve(buf_vert_, sizeof(int) * vertSize_, CL_MEM_READ_WRITE);
+
+        // Read/Write/Map/Copy
+        // blocking = CL_TRUE for sync
+        qu_.enqueueWriteBuffer(*buf_A_, CL_TRUE, 0, sizeof(char) * m_, A.data());
+        qu_.enqueueWriteBuffer(*buf_B_, CL_TRUE, 0, sizeof(char) * n_, B.data());
+
+        // Zero padding: row 0 & column 0
+        qu_.enqueueFillBuffer(*buf_horiz_, 0, 0, sizeof(int) * horizSize_);
+        qu_.enqueueFillBuffer(*buf_vert_, 0, 0, sizeof(int) * vertSize_);
+
+        cl::compatibility::make_kernel<cl::Buffer, cl::Buffer, int, int, int, int, cl::Buffer, cl::Buffer> lcs_kern(kern_);
+
+        qu_.finish();
+        auto start = std::chrono::steady_clock::now();
+
+        // In-order queue: launch d+1 starts after launch d is done, which is all the wavefront needs
+        // Anti-diagonal d holds tiles ti in [max(0, d - tilesJ + 1), min(d, tilesI - 1)]
+        for (int d = 0; d < tilesI + tilesJ - 1; d++) {
+            int tiStart = std::max(0, d - tilesJ + 1);
+            int tiEnd = std::min(d, tilesI - 1);
+            int nTiles = tiEnd - tiStart + 1;
+
+            cl::NDRange global(nTiles * TILE);
+            cl::NDRange local(TILE);
+            lcs_kern(cl::EnqueueArgs(qu_, global, local),
+                *buf_A_, *buf_B_, m_, n_, d, tiStart, *buf_horiz_, *buf_vert_);
+        }
+        qu_.finish();
+        t_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int len;
+        qu_.enqueueReadBuffer(*buf_horiz_, CL_TRUE, sizeof(int) * ((size_t)tilesI * (n_ + 1) + n_), sizeof(int), &len);
+        return len;
+    }
+
+    // Tile boundaries of the last run, for the traceback
+    void boundaries(std::vector<int>& horiz, std::vector<int>& vert) {
+        horiz.resize(horizSize_);
+        vert.resize(vertSize_);
+        qu_.enqueueReadBuffer(*buf_horiz_, CL_TRUE, 0, sizeof(int) * horizSize_, horiz.data());
+        qu_.enqueueReadBuffer(*buf_vert_, CL_TRUE, 0, sizeof(int) * vertSize_, vert.data());
+    }
+
+    double seconds() const { return t_; }
+    const ClCacheStat& buildStat() const { return buildStat_; }
+
+private:
+    void reserve(PooledBuffer& buf, size_t bytes, cl_mem_flags flags) {
+        if (bytes > buf.capacity())
+            buf = rt_.pool().acquire(bytes, flags);
+    }
+
+    ClRuntime& rt_;
+    cl::CommandQueue& qu_;
+    cl::Program prog_;
+    cl::Kernel kern_;
+    ClCacheStat buildStat_;
+    int m_ = 0, n_ = 0;
+    size_t horizSize_ = 0, vertSize_ = 0;
+    double t_ = 0;
+
+    PooledBuffer buf_A_, buf_B_, buf_horiz_, buf_vert_;
+};
+
+
+
+// ------ Multi-device wavefront ------
+// B is cut into column strips, 1 per device / sub-device (widths by compute units x clock, whole tiles),
+// each with its own context, queue & boundary buffers; A goes to all of them.
+// Strip k's column 0 is strip k - 1's last column: the table is swept in bands of tile rows, device k on
+// band b while device k - 1 is on band b + 1, and after each step the band's right column goes through
+// the host into the next device's vert[0] (halo exchange: separate contexts, so no shared events).
+class LCSMulti {
+public:
+    explicit LCSMulti(const std::vector<cl::Device>& devs = deviceSet()) {
+        for (const cl::Device& d : devs) {
+            if (d.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() < TILE)
+                continue;
+            units_.emplace_back(d);
+            Unit& u = units_.back();
+            u.kern = cl::Kernel(u.dev.program(lcsWaveKern, "-D TILE=" + std::to_string(TILE)), "lcs_kern");
+        }
+        if (units_.empty()) {
+            std::cout << " No device with max work-group size >= TILE (" << TILE << ").\n";
+            exit(1);
+        }
+    }
+
+    size_t devices() const { return units_.size(); }
+    const ClDevice& device(size_t k) const { return units_[k].dev; }
+    // Strip starts in B of the last run (devices used + 1 entries)
+    const std::vector<size_t>& strips() const { return strip_; }
+
+    // LCS length of A x B (both non-empty). Sweep time (s, uploads excluded): seconds()
+    int run(const std::string& A, const std::string& B) {
+        int m = A.size(), n = B.size();
+        int tilesI = (m + TILE - 1) / TILE;
+        std::vector<double> weight;
+        for (size_t k = 0; k < units_.size() && k * TILE < (size_t)n; k++)
+            weight.push_back(units_[k].dev.weight());
+        strip_ = splitByWeight(n, weight, TILE);
+        while (strip_.size() > 2 && strip_[strip_.size() - 2] == (size_t)n) // the last strip holds the result
+            strip_.erase(strip_.end() - 2);
+        int K = strip_.size() - 1;
+
+        for (int k = 0; k < K; k++) {
+            Unit& u = units_[k];
+            cl::CommandQueue& q = u.dev.queue();
+            u.n = strip_[k + 1] - strip_[k];
+            u.tilesJ = (u.n + TILE - 1) / TILE;
+            size_t horizSize = (size_t)(tilesI + 1) * (u.n + 1), vertSize = (size_t)(u.tilesJ + 1) * (m + 1);
+            reserveBuffer(u.dev.context(), u.a, u.capA, m, CL_MEM_READ_ONLY);
+            reserveBuffer(u.dev.context(), u.b, u.capB, std::max(1, u.n), CL_MEM_READ_ONLY);
+            reserveBuffer(u.dev.context(), u.horiz, u.capHoriz, horizSize * sizeof(int), CL_MEM_READ_WRITE);
+            reserveBuffer(u.dev.context(), u.vert, u.capVert, vertSize * sizeof(int), CL_MEM_READ_WRITE);
+            q.enqueueWriteBuffer(u.a, CL_FALSE, 0, m, A.data());
+            if (u.n > 0)
+                q.enqueueWriteBuffer(u.b, CL_FALSE, 0, u.n, B.data() + strip_[k]);
+            q.enqueueFillBuffer(u.horiz, 0, 0, horizSize * sizeof(int));
+            q.enqueueFillBuffer(u.vert, 0, 0, vertSize * sizeof(int));
+            u.col.assign(m + 1, 0);
+        }
+        for (int k = 0; k < K; k++)
+            units_[k].dev.queue().finish();
+
+        // Band: LCS_MULTI_BAND tile rows, enough bands to keep the pipeline full
+        const char* env = getenv("LCS_MULTI_BAND");
+        int R = env ? atoi(env) : tilesI / (4 * K);
+        R = std::max(1, std::min(R, tilesI));
+        int bands = (tilesI + R - 1) / R;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int step = 0; step < bands + K - 1; step++) {
+            // Halo exchange first: unit k - 1 finished band b in the previous step
+            for (int k = 1; k < K; k++) {
+                int b = step - k;
+                if (b < 0 || b >= bands)
+                    continue;
+                Unit &src = units_[k - 1], &dst = units_[k];
+                size_t r0 = (size_t)b * R * TILE, r1 = std::min<size_t>(m, (size_t)(b + 1) * R * TILE);
+                src.dev.queue().enqueueReadBuffer(src.vert, CL_TRUE, ((size_t)src.tilesJ * (m + 1) + r0 + 1) * sizeof(int),
+                                                  (r1 - r0) * sizeof(int), dst.col.data() + r0 + 1);
+                dst.dev.queue().enqueueWriteBuffer(dst.vert, CL_FALSE, (r0 + 1) * sizeof(int), (r1 - r0) * sizeof(int),
+                                                   dst.col.data() + r0 + 1);
+            }
+            for (int k = 0; k < K; k++) {
+                int b = step - k;
+                if (b < 0 || b >= bands)
+                    continue;
+                Unit& u = units_[k];
+                int ti0 = b * R, ti1 = std::min(tilesI, ti0 + R);
+                u.kern.setArg(0, u.a);
+                u.kern.setArg(1, u.b);
+                u.kern.setArg(2, m);
+                u.kern.setArg(3, u.n);
+                u.kern.setArg(6, u.horiz);
+                u.kern.setArg(7, u.vert);
+                for (int d = ti0; d < ti1 - 1 + u.tilesJ; d++) {
+                    int tiStart = std::max(ti0, d - u.tilesJ + 1);
+                    int tiEnd = std::min(d, ti1 - 1);
+                    u.kern.setArg(4, d);
+                    u.kern.setArg(5, tiStart);
+                    u.dev.queue().enqueueNDRangeKernel(u.kern, cl::NullRange, cl::NDRange((tiEnd - tiStart + 1) * TILE),
+                                                       cl::NDRange(TILE));
+                }
+                u.dev.queue().flush();
+            }
+        }
+        for (int k = 0; k < K; k++)
+            units_[k].dev.queue().finish();
+        t_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Unit& last = units_[K - 1];
+        int len;
+        last.dev.queue().enqueueReadBuffer(last.horiz, CL_TRUE, sizeof(int) * ((size_t)tilesI * (last.n + 1) + last.n),
+                                           sizeof(int), &len);
+        return len;
+    }
+
+    double seconds() const { return t_; }
+
+private:
+    struct Unit {
+        explicit Unit(const cl::Device& d) : dev(d) {}
+        ClDevice dev;
+        cl::Kernel kern;
+        cl::Buffer a, b, horiz, vert;
+        size_t capA = 0, capB = 0, capHoriz = 0, capVert = 0;
+        int n = 0, tilesJ = 0;
+        std::vector<int> col; // staging for the left boundary column
+    };
+    std::deque<Unit> units_; // deque: ClDevice holds a mutex
+    std::vector<size_t> strip_;
+    double t_ = 0;
+};
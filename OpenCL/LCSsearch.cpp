@@ -0,0 +1,117 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <cctype>
+#include "LCSsearch.hpp"
+
+/*
+    Top-k LCS search (LCSsearch.hpp)
+    ./LCSsearch [N] [LEN]                synthetic corpus, checked against scoring every record
+    ./LCSsearch build text store         1 record per line / FASTA entry
+    ./LCSsearch query store k query
+    Synthetic: N random word records of LEN / 2 .. 3 LEN / 2 chars + near copies of the query
+    (substitutions, insertions, deletions)
+*/
+
+#define N_RECORDS 200000
+#define LEN 200
+#define PLANTED 50
+#define TOP_K 10
+
+static std::string words(std::mt19937& gen, int len) {
+    std::string s;
+    while ((int)s.size() < len) {
+        int w = 2 + gen() % 7;
+        for (int c = 0; c < w; c++)
+            s += 'a' + gen() % 26;
+        s += ' ';
+    }
+    s.resize(len);
+    return s;
+}
+
+static void print(const LCSStore& store, const std::vector<LCSHit>& top) {
+    for (const LCSHit& h : top)
+        std::cout << "  " << h.len << "  #" << h.rec << "  " << store[h.rec].substr(0, 60) << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "demo";
+    int nRec = argc > 1 && isdigit(argv[1][0]) ? atoi(argv[1]) : N_RECORDS;
+    int len = argc > 2 && isdigit(argv[1][0]) ? atoi(argv[2]) : LEN;
+    if (mode == "build" && argc > 3) {
+        auto start = std::chrono::steady_clock::now();
+        size_t n = LCSStore::build(argv[2], argv[3]);
+        std::cout << n << " records, "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s\n";
+        return 0;
+    }
+    if (mode == "query" && argc > 4) {
+        LCSStore store(argv[2]);
+        LCSSearchStats st;
+        std::vector<LCSHit> top = store.topK(argv[4], atoi(argv[3]), &st);
+        print(store, top);
+        lcsSearchReport(st);
+        return 0;
+    }
+
+    // ------ Synthetic corpus ------
+    std::mt19937 gen(7);
+    std::string query = words(gen, len);
+    std::string text = "LCSsearch_demo.txt", path = "LCSsearch_demo.store";
+    {
+        std::ofstream out(text, std::ios::binary);
+        for (int r = 0; r < nRec; r++) {
+            if (r % std::max(1, nRec / PLANTED) == 0) {
+                std::string s;
+                int edits = gen() % 60; // per 200 chars
+                for (char c : query) {
+                    int e = gen() % 200;
+                    if (e < edits / 3)
+                        continue;
+                    if (e < 2 * edits / 3)
+                        s += 'a' + gen() % 26;
+                    s += e < edits ? (char)('a' + gen() % 26) : c;
+                }
+                out << s << "\n";
+            }
+            else
+                out << words(gen, len / 2 + gen() % (len + 1)) << "\n";
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    LCSStore::build(text, path);
+    std::cout << "Build: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << " s\n";
+
+    LCSStore store(path);
+    LCSSearchStats st;
+    std::vector<LCSHit> top = store.topK(query, TOP_K, &st);
+    std::cout << "Top " << TOP_K << " of " << store.size() << ":\n";
+    print(store, top);
+    lcsSearchReport(st);
+
+    // ------ Every record through the DP ------
+    start = std::chrono::steady_clock::now();
+    LCSBitpar engine(query);
+    std::vector<LCSHit> all(store.size());
+    #pragma omp parallel for schedule(dynamic, 256)
+    for (long r = 0; r < (long)store.size(); r++)
+        all[r] = { (uint32_t)r, (int)engine.length(store[r]) };
+    std::sort(all.begin(), all.end(), [](const LCSHit& x, const LCSHit& y) {
+        return x.len != y.len ? x.len > y.len : x.rec < y.rec;
+    });
+    double tAll = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int mismatch = 0;
+    for (size_t i = 0; i < top.size(); i++)
+        mismatch += top[i].rec != all[i].rec || top[i].len != all[i].len;
+    std::cout << "Exhaustive: " << tAll * 1e3 << " ms (" << tAll / st.seconds << "x), mismatches: " << mismatch << std::endl;
+
+    remove(text.c_str());
+    remove(path.c_str());
+    return mismatch != 0;
+}
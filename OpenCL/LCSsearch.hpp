@@ -0,0 +1,318 @@
+#pragma once
+#include <omp.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "LCSbitpar.hpp"
+
+/*
+    Top-k LCS search over a corpus
+    LCSStore::build(text, store): 1 record per line (or per FASTA entry), written once as 1 packed file:
+        header | offs[count + 1] | hist[count][LCS_SEARCH_BUCKETS] | gramOffs[count + 1] | grams | bytes
+    LCSStore(store) maps it read-only: loading is O(1), pages come in as the search touches them.
+
+    topK(q, k): records ranked by LCS(q, r) (ties: lower index first). Upper bounds, cheapest first:
+        length     LCS <= min(m, n)
+        histogram  LCS <= sum_b min(hq[b], hr[b]), chars folded into LCS_SEARCH_BUCKETS buckets
+        q-gram     every indel destroys <= Q q-grams of the longer string (Jokinen-Ukkonen), so with
+                   c = #common q-grams (multiset): indel distance D >= (max(m, n) - Q + 1 - c) / Q and
+                   LCS = (m + n - D) / 2. Sorted q-gram lists per record, 1 merge per candidate.
+    Best first: length & histogram bounds of all records (offs & hist only), then the candidate with the
+    highest bound gets its q-gram bound, or is verified once it has one (bit-parallel engine, query masks
+    built once). Batches of candidates run in parallel: max(k, LCS_SEARCH_BATCH_THREAD x threads) at first, so
+    a record the bounds would prune is rarely scored, doubled (up to LCS_SEARCH_BATCH_MAX) after a round
+    whose verified records could not enter the top k. Near copies come up first and raise the k-th
+    best early. Once the best remaining bound cannot enter the top k, the records left are never read.
+*/
+
+#define LCS_SEARCH_BUCKETS 32
+#define LCS_SEARCH_Q 3        // q-gram = Q bytes packed into 1 uint32: exact, no hashing
+#define LCS_SEARCH_BATCH_THREAD 8 // first batch: candidates bounded / verified in parallel, per thread
+#define LCS_SEARCH_BATCH_MAX 1024  // batches grow up to this while rounds find nothing to enter the top k
+
+struct LCSStoreHeader {
+    char magic[8];
+    uint64_t count, grams, bytes;
+};
+
+struct LCSHit {
+    uint32_t rec;
+    int len;
+};
+
+struct LCSSearchStats {
+    size_t records = 0;
+    size_t lengthPruned = 0, histPruned = 0, qgramPruned = 0, verified = 0;
+    size_t batches = 0;
+    double seconds = 0;
+};
+
+inline void lcsSearchReport(const LCSSearchStats& s, std::ostream& os = std::cout) {
+    auto pct = [&](size_t x) { return 100.0 * x / std::max<size_t>(1, s.records); };
+    os << "  records: " << s.records << ", batches: " << s.batches << ", " << s.seconds * 1e3 << " ms\n"
+       << "  pruned by length:    " << s.lengthPruned << " (" << pct(s.lengthPruned) << "%)\n"
+       << "  pruned by histogram: " << s.histPruned << " (" << pct(s.histPruned) << "%)\n"
+       << "  pruned by q-grams:   " << s.qgramPruned << " (" << pct(s.qgramPruned) << "%)\n"
+       << "  verified by DP:      " << s.verified << " (" << pct(s.verified) << "%)" << std::endl;
+}
+
+// Sorted q-grams of s (with repeats)
+inline std::vector<uint32_t> lcsGrams(std::string_view s) {
+    std::vector<uint32_t> g;
+    if (s.size() < LCS_SEARCH_Q)
+        return g;
+    g.reserve(s.size() - LCS_SEARCH_Q + 1);
+    uint32_t h = 0;
+    for (size_t i = 0; i < s.size(); i++) {
+        h = (h << 8 | (unsigned char)s[i]) & (uint32_t)((1ULL << 8 * LCS_SEARCH_Q) - 1);
+        if (i + 1 >= LCS_SEARCH_Q)
+            g.push_back(h);
+    }
+    std::sort(g.begin(), g.end());
+    return g;
+}
+
+inline void lcsHist(std::string_view s, uint32_t* hist) {
+    std::fill(hist, hist + LCS_SEARCH_BUCKETS, 0);
+    for (unsigned char c : s)
+        hist[c % LCS_SEARCH_BUCKETS]++;
+}
+
+
+
+class LCSStore {
+public:
+    // FASTA (first byte '>'): 1 record per entry, else 1 per line ('\r' dropped). Returns the record count
+    static size_t build(const std::string& textPath, const std::string& storePath) {
+        std::ifstream in(textPath, std::ios::binary);
+        if (!in)
+            die("Cannot open " + textPath);
+        std::vector<std::string> recs;
+        std::string line;
+        bool fasta = in.peek() == '>';
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!fasta)
+                recs.push_back(line);
+            else if (!line.empty() && line[0] == '>')
+                recs.emplace_back();
+            else if (!recs.empty())
+                recs.back() += line;
+        }
+
+        size_t count = recs.size();
+        std::vector<uint64_t> offs(count + 1, 0), gramOffs(count + 1, 0);
+        for (size_t r = 0; r < count; r++) {
+            offs[r + 1] = offs[r] + recs[r].size();
+            gramOffs[r + 1] = gramOffs[r] + (recs[r].size() >= LCS_SEARCH_Q ? recs[r].size() - LCS_SEARCH_Q + 1 : 0);
+        }
+        std::vector<uint32_t> hist(count * LCS_SEARCH_BUCKETS), grams(gramOffs[count]);
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (long r = 0; r < (long)count; r++) {
+            lcsHist(recs[r], &hist[r * LCS_SEARCH_BUCKETS]);
+            std::vector<uint32_t> g = lcsGrams(recs[r]);
+            std::copy(g.begin(), g.end(), grams.begin() + gramOffs[r]);
+        }
+
+        LCSStoreHeader h = { { 'L', 'C', 'S', 'S', 'T', 'O', 'R', '1' }, count, gramOffs[count], offs[count] };
+        std::ofstream out(storePath, std::ios::binary | std::ios::trunc);
+        if (!out)
+            die("Cannot create " + storePath);
+        out.write((const char*)&h, sizeof(h));
+        out.write((const char*)offs.data(), offs.size() * sizeof(uint64_t));
+        out.write((const char*)hist.data(), hist.size() * sizeof(uint32_t));
+        out.write((const char*)gramOffs.data(), gramOffs.size() * sizeof(uint64_t));
+        out.write((const char*)grams.data(), grams.size() * sizeof(uint32_t));
+        for (const std::string& s : recs)
+            out.write(s.data(), s.size());
+        if (!out)
+            die("Cannot write " + storePath);
+        return count;
+    }
+
+    explicit LCSStore(const std::string& storePath) {
+        int fd = open(storePath.c_str(), O_RDONLY);
+        if (fd < 0)
+            die("Cannot open " + storePath);
+        struct stat st;
+        fstat(fd, &st);
+        len_ = st.st_size;
+        void* p = len_ >= sizeof(LCSStoreHeader) ? mmap(nullptr, len_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (p == MAP_FAILED)
+            die("Cannot map " + storePath);
+        base_ = (const char*)p;
+        const LCSStoreHeader* h = (const LCSStoreHeader*)base_;
+        if (memcmp(h->magic, "LCSSTOR1", 8)) {
+            std::cout << " " << storePath << " is not an LCS store.\n";
+            exit(1);
+        }
+        count_ = h->count;
+        offs_ = (const uint64_t*)(h + 1);
+        hist_ = (const uint32_t*)(offs_ + count_ + 1);
+        gramOffs_ = (const uint64_t*)(hist_ + count_ * LCS_SEARCH_BUCKETS);
+        grams_ = (const uint32_t*)(gramOffs_ + count_ + 1);
+        bytes_ = (const char*)(grams_ + h->grams);
+        if (bytes_ + h->bytes != base_ + len_) {
+            std::cout << " " << storePath << " is truncated.\n";
+            exit(1);
+        }
+    }
+
+    ~LCSStore() { munmap((void*)base_, len_); }
+    LCSStore(const LCSStore&) = delete;
+    LCSStore& operator=(const LCSStore&) = delete;
+
+    size_t size() const { return count_; }
+    std::string_view operator[](size_t r) const { return std::string_view(bytes_ + offs_[r], offs_[r + 1] - offs_[r]); }
+
+    std::vector<LCSHit> topK(std::string_view q, size_t k, LCSSearchStats* stats = nullptr) const {
+        auto start = std::chrono::steady_clock::now();
+        LCSSearchStats st;
+        st.records = count_;
+        std::vector<LCSHit> top;
+        if (k == 0 || count_ == 0) {
+            if (stats)
+                *stats = st;
+            return top;
+        }
+        uint32_t qh[LCS_SEARCH_BUCKETS];
+        lcsHist(q, qh);
+        std::vector<uint32_t> qg = lcsGrams(q);
+        LCSBitpar engine(q);
+
+        // Cheap bounds of every record: reads offs & hist only
+        std::vector<int> lenB(count_), histB(count_);
+        #pragma omp parallel for schedule(static)
+        for (long r = 0; r < (long)count_; r++) {
+            lenB[r] = std::min<uint64_t>(q.size(), offs_[r + 1] - offs_[r]);
+            const uint32_t* h = hist_ + r * LCS_SEARCH_BUCKETS;
+            int s = 0;
+            for (int b = 0; b < LCS_SEARCH_BUCKETS; b++)
+                s += std::min(qh[b], h[b]);
+            histB[r] = std::min(lenB[r], s);
+        }
+        // Max-heap on the tightest bound known so far
+        struct Cand {
+            int bound;
+            uint32_t rec;
+            bool refined;
+        };
+        auto lower = [](const Cand& x, const Cand& y) { return x.bound != y.bound ? x.bound < y.bound : x.rec > y.rec; };
+        std::vector<Cand> heap(count_);
+        for (size_t r = 0; r < count_; r++)
+            heap[r] = { histB[r], (uint32_t)r, false };
+        std::make_heap(heap.begin(), heap.end(), lower);
+
+        // Can (bound, rec) still enter the top k: rank by length desc, then index asc
+        auto enters = [&](int bound, uint32_t rec) {
+            return top.size() < k || bound > top.back().len || (bound == top.back().len && rec < top.back().rec);
+        };
+        std::vector<Cand> batch;
+        std::vector<int> got;
+        size_t batchSize = std::max<size_t>(k, LCS_SEARCH_BATCH_THREAD * omp_get_max_threads());
+        while (!heap.empty() && enters(heap.front().bound, heap.front().rec)) {
+            batch.clear();
+            while (batch.size() < batchSize && !heap.empty() && enters(heap.front().bound, heap.front().rec)) {
+                std::pop_heap(heap.begin(), heap.end(), lower);
+                batch.push_back(heap.back());
+                heap.pop_back();
+            }
+            st.batches++;
+            got.assign(batch.size(), -1);
+            #pragma omp parallel for schedule(dynamic, 8)
+            for (long i = 0; i < (long)batch.size(); i++) {
+                Cand& c = batch[i];
+                std::string_view s = (*this)[c.rec];
+                if (c.refined)
+                    got[i] = engine.length(s);
+                else {
+                    c.bound = std::min(c.bound, qgramBound(q.size(), s.size(), qg, c.rec));
+                    c.refined = true;
+                }
+            }
+            bool entered = false;
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (got[i] >= 0) {
+                    st.verified++;
+                    entered |= enters(got[i], batch[i].rec);
+                    top.push_back({ batch[i].rec, got[i] });
+                }
+                else if (enters(batch[i].bound, batch[i].rec)) {
+                    heap.push_back(batch[i]);
+                    std::push_heap(heap.begin(), heap.end(), lower);
+                }
+                else
+                    st.qgramPruned++;
+            }
+            std::sort(top.begin(), top.end(), [](const LCSHit& x, const LCSHit& y) {
+                return x.len != y.len ? x.len > y.len : x.rec < y.rec;
+            });
+            if (top.size() > k)
+                top.resize(k);
+            if (!entered && batchSize < LCS_SEARCH_BATCH_MAX)
+                batchSize = std::min<size_t>(2 * batchSize, LCS_SEARCH_BATCH_MAX);
+        }
+        // Left in the heap: counted under the first bound that keeps them out
+        for (const Cand& c : heap) {
+            if (!enters(lenB[c.rec], c.rec))
+                st.lengthPruned++;
+            else if (!enters(histB[c.rec], c.rec))
+                st.histPruned++;
+            else
+                st.qgramPruned++;
+        }
+        st.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (stats)
+            *stats = st;
+        return top;
+    }
+
+private:
+    static void die(const std::string& msg) {
+        std::cerr << msg << ": " << strerror(errno) << std::endl;
+        exit(1);
+    }
+
+    // LCS bound from the common q-grams of the query (sorted qg) & record r
+    int qgramBound(size_t m, size_t n, const std::vector<uint32_t>& qg, uint32_t r) const {
+        const uint32_t* g = grams_ + gramOffs_[r];
+        const uint32_t* gEnd = grams_ + gramOffs_[r + 1];
+        size_t i = 0, common = 0;
+        while (i < qg.size() && g < gEnd) {
+            if (qg[i] < *g)
+                i++;
+            else if (*g < qg[i])
+                g++;
+            else {
+                common++;
+                i++;
+                g++;
+            }
+        }
+        long miss = (long)std::max(m, n) - LCS_SEARCH_Q + 1 - (long)common;
+        long dMin = miss > 0 ? (miss + LCS_SEARCH_Q - 1) / LCS_SEARCH_Q : 0;
+        return std::min<long>(std::min(m, n), ((long)m + (long)n - dMin) / 2);
+    }
+
+    const char* base_ = nullptr;
+    size_t len_ = 0, count_ = 0;
+    const uint64_t* offs_ = nullptr;
+    const uint32_t* hist_ = nullptr;
+    const uint64_t* gramOffs_ = nullptr;
+    const uint32_t* grams_ = nullptr;
+    const char* bytes_ = nullptr;
+};
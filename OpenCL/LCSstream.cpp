@@ -0,0 +1,315 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+/*
+    Streaming LCS for inputs that do not fit in memory
+    ./LCSstream fileA fileB [outFile] [BAND]
+    Inputs are memory-mapped, FASTA (leading '>') or raw bytes. Scratch files go to $LCS_SCRATCH (default .)
+
+    The table is swept in row bands of BAND rows, each band in column strips of BAND columns.
+    Live state: 1 strip-row (BAND + 1) + 1 strip-column (BAND), so RSS does not grow with m or n.
+    The top row of every band is a checkpoint row on disk ((m / BAND + 1) x (n + 1) uint32).
+
+    Traceback, band by band from the bottom: recompute the band from its checkpoint row up to the exit
+    column, spilling each strip's left column to disk, then walk the strips right to left,
+    recomputing 1 BAND x BAND tile at a time. Total work ~2x the forward pass.
+*/
+
+#define BAND 2048
+
+typedef uint32_t cell;
+
+
+
+// ------ Memory-mapped input ------
+struct MappedSeq {
+    const char* data = nullptr;
+    size_t len = 0;
+    int fd = -1;
+};
+
+static void die(const std::string& msg) {
+    std::cerr << msg << ": " << strerror(errno) << std::endl;
+    exit(1);
+}
+
+static int scratchFile(const char* tag) {
+    const char* dir = getenv("LCS_SCRATCH");
+    std::string path = std::string(dir ? dir : ".") + "/lcs_" + tag + "_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0)
+        die("Cannot create scratch file " + path);
+    unlink(path.c_str()); // freed on close / exit
+    return fd;
+}
+
+// Drop mapped pages of [p, p + len) from RSS, they are re-read from the page cache on demand
+static void dropPages(const void* p, size_t len) {
+    static const uintptr_t pg = sysconf(_SC_PAGESIZE);
+    uintptr_t s = (uintptr_t)p & ~(pg - 1);
+    uintptr_t e = ((uintptr_t)p + len + pg - 1) & ~(pg - 1);
+    if (e > s)
+        madvise((void*)s, e - s, MADV_DONTNEED);
+}
+
+static MappedSeq mapRaw(int fd) {
+    MappedSeq s;
+    struct stat st;
+    fstat(fd, &st);
+    s.fd = fd;
+    s.len = st.st_size;
+    if (s.len == 0)
+        return s;
+    void* p = mmap(nullptr, s.len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+        die("mmap");
+    madvise(p, s.len, MADV_SEQUENTIAL);
+    s.data = (const char*)p;
+    return s;
+}
+
+// FASTA: header lines & whitespace stripped into a raw scratch file, streamed in 1 MB chunks
+static MappedSeq mapSeq(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        die(std::string("Cannot open ") + path);
+    MappedSeq in = mapRaw(fd);
+    if (in.len == 0 || in.data[0] != '>')
+        return in;
+
+    int out = scratchFile("raw");
+    std::vector<char> buf;
+    buf.reserve(1 << 20);
+    bool header = false;
+    for (size_t k = 0; k < in.len; k++) {
+        char c = in.data[k];
+        if (c == '>')
+            header = true;
+        else if (c == '\n')
+            header = false;
+        else if (!header && c != '\r' && c != ' ' && c != '\t')
+            buf.push_back(c);
+        if (buf.size() == buf.capacity() || k + 1 == in.len) {
+            if (write(out, buf.data(), buf.size()) != (ssize_t)buf.size())
+                die("write");
+            buf.clear();
+            dropPages(in.data, k + 1);
+        }
+    }
+    munmap((void*)in.data, in.len);
+    close(fd);
+    return mapRaw(out);
+}
+
+
+
+// ------ Checkpoint rows on disk: row b = table row b * BAND ------
+struct Checkpoints {
+    int fd;
+    size_t n;
+    void read(size_t b, size_t j0, size_t cnt, cell* dst) const {
+        if (pread(fd, dst, cnt * sizeof(cell), (b * (n + 1) + j0) * sizeof(cell)) != (ssize_t)(cnt * sizeof(cell)))
+            die("pread checkpoint");
+    }
+    void write(size_t b, size_t j0, size_t cnt, const cell* src) const {
+        if (pwrite(fd, src, cnt * sizeof(cell), (b * (n + 1) + j0) * sizeof(cell)) != (ssize_t)(cnt * sizeof(cell)))
+            die("pwrite checkpoint");
+    }
+};
+
+// Tile of h rows x w columns. top: w + 1 cells (top[0] = corner), col: in = left column, out = right column.
+// row (w + 1 cells) gets the last row
+static void tileForward(const char* a, const char* b, size_t h, size_t w,
+                        const cell* top, cell* col, std::vector<cell>& row) {
+    row.assign(top, top + w + 1);
+    for (size_t r = 1; r <= h; r++) {
+        cell diag = row[0];
+        row[0] = col[r - 1];
+        char ar = a[r - 1];
+        for (size_t c = 1; c <= w; c++) {
+            cell up = row[c];
+            row[c] = (ar == b[c - 1]) ? diag + 1 : std::max(up, row[c - 1]);
+            diag = up;
+        }
+        col[r - 1] = row[w];
+    }
+}
+
+// Same, full (h + 1) x (w + 1) tile kept for the traceback
+static void tileFull(const char* a, const char* b, size_t h, size_t w,
+                     const cell* top, const cell* left, std::vector<cell>& tab) {
+    tab.resize((h + 1) * (w + 1));
+    std::copy(top, top + w + 1, tab.begin());
+    for (size_t r = 1; r <= h; r++) {
+        cell* row = &tab[r * (w + 1)];
+        const cell* up = row - (w + 1);
+        row[0] = left[r - 1];
+        for (size_t c = 1; c <= w; c++)
+            row[c] = (a[r - 1] == b[c - 1]) ? up[c - 1] + 1 : std::max(up[c], row[c - 1]);
+    }
+}
+
+// Traceback emits the LCS back to front: buffered, written at its final offset
+struct RevWriter {
+    int fd;
+    size_t pos; // chars still to be written before the current chunk
+    std::string buf;
+    void put(char c) {
+        buf += c;
+        if (buf.size() == (1 << 20))
+            flush();
+    }
+    void flush() {
+        std::reverse(buf.begin(), buf.end());
+        pos -= buf.size();
+        if (pwrite(fd, buf.data(), buf.size(), pos) != (ssize_t)buf.size())
+            die("pwrite LCS");
+        buf.clear();
+    }
+};
+
+
+
+int main(int argc, char** argv) {
+    size_t H = argc > 4 ? strtoull(argv[4], nullptr, 10) : BAND; // 0 also for non-numeric text
+    if (argc < 3 || H == 0) {
+        std::cout << "Usage: " << argv[0] << " fileA fileB [outFile] [BAND], BAND >= 1\n";
+        return 1;
+    }
+    const char* outPath = argc > 3 ? argv[3] : "lcs_out.txt";
+    size_t W = H;
+
+    MappedSeq A = mapSeq(argv[1]);
+    MappedSeq B = mapSeq(argv[2]);
+    size_t m = A.len;
+    size_t n = B.len;
+    size_t nBands = (m + H - 1) / H;
+    size_t nStrips = (n + W - 1) / W;
+    std::cout << "m = " << m << ", n = " << n << ", band = " << H << "\n";
+    std::cout << "Checkpoint rows on disk: " << (nBands + 1) * (n + 1) * sizeof(cell) / (1 << 20) << " MB\n";
+
+    Checkpoints ckpt{ scratchFile("ckpt"), n };
+    std::vector<cell> top(W + 1), row, col(H);
+    std::vector<cell> zeros(n + 1 > W + 1 ? W + 1 : n + 1, 0);
+    for (size_t j0 = 0; j0 <= n; j0 += zeros.size()) // row 0
+        ckpt.write(0, j0, std::min(zeros.size(), n + 1 - j0), zeros.data());
+
+    // ------ Forward: band by band, strip by strip ------
+    auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < nBands; b++) {
+        size_t r0 = b * H;
+        size_t h = std::min(H, m - r0);
+        std::fill(col.begin(), col.begin() + h, 0); // column 0
+        cell zero = 0;
+        ckpt.write(b + 1, 0, 1, &zero);
+        for (size_t s = 0; s < nStrips; s++) {
+            size_t s0 = s * W;
+            size_t w = std::min(W, n - s0);
+            ckpt.read(b, s0, w + 1, top.data());
+            tileForward(A.data + r0, B.data + s0, h, w, top.data(), col.data(), row);
+            ckpt.write(b + 1, s0 + 1, w, row.data() + 1);
+            dropPages(B.data + s0, w);
+        }
+        dropPages(A.data + r0, h);
+    }
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cell len = 0;
+    if (m > 0 && n > 0)
+        ckpt.read(nBands, n, 1, &len);
+    std::cout << "LCS length: " << len << "\n";
+    std::cout << "Forward time (s): " << t << ", GCUPS: " << (double)m * n / t * 1e-9 << "\n";
+
+    // ------ Traceback: band by band from the bottom ------
+    start = std::chrono::steady_clock::now();
+    int out = open(outPath, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (out < 0)
+        die(std::string("Cannot open ") + outPath);
+    if (ftruncate(out, len) != 0)
+        die("ftruncate");
+    RevWriter rw{ out, len, "" };
+
+    int colsFd = scratchFile("cols");
+    std::vector<cell> tab, left(H);
+    size_t i = m, j = n;
+    while (i > 0 && j > 0) {
+        size_t b = (i - 1) / H;
+        size_t r0 = b * H;
+        size_t h = i - r0;
+        size_t S = (j - 1) / W; // strip holding column j
+
+        // recompute the band up to column j, spilling each strip's left column
+        std::fill(col.begin(), col.begin() + h, 0);
+        for (size_t s = 0; s <= S; s++) {
+            size_t s0 = s * W;
+            size_t w = std::min(W, j - s0);
+            if (pwrite(colsFd, col.data(), h * sizeof(cell), s * H * sizeof(cell)) != (ssize_t)(h * sizeof(cell)))
+                die("pwrite column");
+            if (s == S)
+                break;
+            ckpt.read(b, s0, w + 1, top.data());
+            tileForward(A.data + r0, B.data + s0, h, w, top.data(), col.data(), row);
+            dropPages(B.data + s0, w);
+        }
+
+        // walk strips right to left until the path leaves the band through its top
+        size_t r = h;
+        size_t s = S;
+        size_t c = j - S * W;
+        while (r > 0) {
+            size_t s0 = s * W;
+            size_t w = (s == S) ? j - s0 : W;
+            ckpt.read(b, s0, w + 1, top.data());
+            if (pread(colsFd, left.data(), h * sizeof(cell), s * H * sizeof(cell)) != (ssize_t)(h * sizeof(cell)))
+                die("pread column");
+            tileFull(A.data + r0, B.data + s0, h, w, top.data(), left.data(), tab);
+
+            while (r > 0 && c > 0) {
+                size_t idx = r * (w + 1) + c;
+                if (A.data[r0 + r - 1] == B.data[s0 + c - 1]) {
+                    rw.put(A.data[r0 + r - 1]);
+                    r--;
+                    c--;
+                }
+                else if (tab[idx - (w + 1)] >= tab[idx - 1])
+                    r--;
+                else
+                    c--;
+            }
+            dropPages(B.data + s0, w);
+            if (c == 0) {
+                if (s == 0)
+                    break; // column 0: done
+                s--;
+                c = W;
+            }
+        }
+        dropPages(A.data + r0, h);
+        if (r > 0 || (s == 0 && c == 0))
+            break;
+        i = r0;
+        j = s * W + c;
+    }
+    rw.flush();
+    close(out);
+    close(colsFd);
+    t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    std::cout << "Traceback time (s): " << t << ", LCS written to " << outPath << "\n";
+    std::cout << "Peak RSS: " << ru.ru_maxrss / 1024 << " MB" << std::endl;
+    return 0;
+}
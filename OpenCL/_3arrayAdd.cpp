@@ -1,6 +1,7 @@
 #include <CL/cl2.hpp>
 #include <iostream>
 #include <vector>
+#include "clRuntime.hpp"
 
 #define SIZE 10
 
@@ -15,28 +16,11 @@ const char* kern = R"(
 
 int main() {
     // ------ Sys env ------
-    std::vector<cl::Platform> all_platforms;
-    cl::Platform::get(&all_platforms);
-
-    cl::Platform plat = all_platforms[0];
-    // Platform
-    std::cout << plat.getInfo<CL_PLATFORM_NAME>() << std::endl;
-
-
-    std::vector<cl::Device> all_devices;
-    plat.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
-    if (all_devices.size() == 0) {
-        std::cout << " No devices found.\n";
-        exit(1);
-    }
-
-    cl::Device dev = all_devices[0];
+    // Device (by policy), context & queues are shared by every sample: clRuntime.hpp
+    ClRuntime& rt = ClRuntime::get();
+    cl::Device dev = rt.device();
     std::cout << "Using device: " << dev.getInfo<CL_DEVICE_NAME>() << "\n";
 
-    // ------ Create context & sources ------
-    cl::Context contxt({ dev });
-    cl::Program::Sources src;
-
     // ------ Input ------
     // Host 
     int A_h[SIZE] = { 0,1,2,3,4,5,6,7,8,9 };
@@ -44,34 +28,32 @@ int main() {
     int C_h[SIZE] = { 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288 };
     // ------ Buffer setup ------
 
-    // Buffer: mem allo. to the dev.
-    cl::Buffer buf_A(contxt, CL_MEM_READ_ONLY, sizeof(int) * SIZE);
-    cl::Buffer buf_B(contxt, CL_MEM_READ_ONLY, sizeof(int) * SIZE);
-    cl::Buffer buf_C(contxt, CL_MEM_READ_ONLY, sizeof(int) * SIZE);
+    // Buffer: mem allo. to the dev., recycled by the runtime's pool
+    PooledBuffer pA = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_ONLY);
+    const cl::Buffer& buf_A = *pA;
+    PooledBuffer pB = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_ONLY);
+    const cl::Buffer& buf_B = *pB;
+    PooledBuffer pC = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_ONLY);
+    const cl::Buffer& buf_C = *pC;
 
-    cl::Buffer buf_D(contxt, CL_MEM_WRITE_ONLY, sizeof(int) * SIZE);
+    PooledBuffer pD = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_WRITE_ONLY);
+    const cl::Buffer& buf_D = *pD;
     // CL_MEM_READ(WRITE)_ONLY / CL_MEM_READ_WRITE
 
 
     // ------ Command (Task) Queue ------
     // Queue: push cmd onto Dev, ~= CUDA streams
-    cl::CommandQueue qu(contxt, dev);
+    cl::CommandQueue& qu = rt.queue();
 
     qu.enqueueWriteBuffer(buf_A, CL_TRUE, 0, sizeof(int) * SIZE, A_h);
     qu.enqueueWriteBuffer(buf_B, CL_TRUE, 0, sizeof(int) * SIZE, B_h);
     qu.enqueueWriteBuffer(buf_C, CL_TRUE, 0, sizeof(int) * SIZE, C_h);
     // ------ Run kernel in source ------
 
-    // push kern to the source code
-    src.push_back({ kern, strlen(kern) });
-    // OpenCL prog: link src to context
-    cl::Program prog(contxt, src);
-
-    // check build
-    if (prog.build({ dev }) != CL_SUCCESS) {
-        std::cout << " Error building: " << prog.getBuildInfo<CL_PROGRAM_BUILD_LOG>(dev) << std::endl;
-        exit(1);
-    }
+    // OpenCL prog: built from kern once, then loaded from the binary cache
+    ClCacheStat buildStat;
+    cl::Program prog = rt.program(kern, "", &buildStat);
+    printCacheStat(buildStat);
     // get_global_id, get_global_size, get_work_dim, get+
     // https://registry.khronos.org/OpenCL/sdk/3.0/docs/man/html/get_work_dim.html
     // https://community.khronos.org/t/when-to-use-get-global-id-and-get-local-id-in-opencl/3999/4
@@ -0,0 +1,121 @@
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "align.hpp"
+
+/*
+    Alignment engine demo (align.hpp)
+    ./align [LEN] [P]
+    1. Scores of 1 pair of length ~LEN: striped (lane width used) vs scalar Gotoh, for local / BLOSUM62,
+       global / DNA, edit distance & LCS
+    2. Traceback of a short pair: CIGAR & gapped rows, alignSeq under LCS scoring vs lcsSeqBitpar
+    3. P pairs: device inter-task batch vs OpenMP host, checked
+*/
+
+#define PROTEIN "ARNDCQEGHILKMFPSTWYV"
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Random sequence & a relative of it: ~1 / 8 substituted, ~1 / 32 inserted or deleted
+static std::pair<std::string, std::string> related(std::mt19937& gen, int len, const char* alphabet) {
+    int k = strlen(alphabet);
+    std::string a(len, ' '), b;
+    for (char& c : a) c = alphabet[gen() % k];
+    for (char c : a) {
+        int r = gen() % 32;
+        if (r == 0)
+            continue;
+        if (r == 1)
+            b += alphabet[gen() % k];
+        b += r < 5 ? alphabet[gen() % k] : c;
+    }
+    return { a, b };
+}
+
+int main(int argc, char** argv) {
+    int len = argc > 1 ? atoi(argv[1]) : 2000;
+    int P = argc > 2 ? atoi(argv[2]) : 2000;
+    std::mt19937 gen(1);
+    int bad = 0;
+
+    // ------ 1 pair ------
+    auto [pa, pb] = related(gen, len, PROTEIN);
+    auto [da, db] = related(gen, len, "ACGT");
+    struct Case {
+        const char* name;
+        std::string a, b;
+        AlignScoring s;
+    };
+    std::vector<Case> cases = {
+        { "local, BLOSUM62 11 / 1", pa, pb, alignBlosum62() },
+        { "global, DNA 2 / -3, 5 / 2", da, db, alignSimple(2, -3, 5, 2, ALIGN_GLOBAL) },
+        { "edit distance", da, db, alignEditScoring(alignAlphabet(da, db)) },
+        { "LCS", da, db, alignLcsScoring(alignAlphabet(da, db)) },
+    };
+    for (Case& c : cases) {
+        double cells = (double)c.a.size() * c.b.size();
+        AlignQuery q(c.a, c.s);
+        q.score(c.b); // profiles built here
+        auto start = std::chrono::steady_clock::now();
+        AlignScore st = q.score(c.b);
+        double tStriped = seconds(start);
+        start = std::chrono::steady_clock::now();
+        int sc = alignScalar(c.a, c.b, c.s);
+        double tScalar = seconds(start);
+        bad += st.score != sc;
+        std::cout << c.name << ": " << st.score << " (" << st.bits << "-bit lanes, " << cells / tStriped * 1e-9
+                  << " GCUPS), scalar " << sc << " (" << cells / tScalar * 1e-9 << " GCUPS)\n";
+    }
+    std::cout << "LCS, bit-parallel: " << lcsLengthBitpar(da, db) << "\n";
+
+    // ------ Traceback ------
+    auto [ta, tb] = related(gen, 60, "ACGT");
+    Alignment al = alignTrace(ta, tb, alignSimple(2, -3, 5, 2, ALIGN_LOCAL));
+    std::cout << "\nLocal alignment, score " << al.score << ", A[" << al.aBegin << ", " << al.aEnd << ") B[" << al.bBegin
+              << ", " << al.bEnd << ") " << al.cigar << "\n  " << al.rowA << "\n  " << al.rowB << "\n";
+    std::string seq = alignSeq(ta, tb, alignLcsScoring(alignAlphabet(ta, tb)));
+    bad += seq.size() != lcsSeqBitpar(ta, tb).size();
+    std::cout << "LCS by traceback: " << seq << "\n";
+
+    // ------ Batch ------
+    SeqPack pack;
+    std::vector<int> pairs;
+    double cells = 0;
+    for (int p = 0; p < P; p++) {
+        auto [a, b] = related(gen, 50 + gen() % 500, PROTEIN);
+        pairs.push_back(pack.add(a));
+        pairs.push_back(pack.add(b));
+        cells += (double)a.size() * b.size();
+    }
+    AlignScoring s = alignBlosum62();
+    ClRuntime& rt = ClRuntime::get();
+    std::cout << "\nUsing device: " << rt.device().getInfo<CL_DEVICE_NAME>() << "\n";
+    AlignBatch batch(rt);
+    std::vector<int> scoresDev, scoresHost;
+    batch.run(pack, pairs, s, scoresDev); // warm-up: build & first-touch buffers
+
+    auto start = std::chrono::steady_clock::now();
+    batch.run(pack, pairs, s, scoresDev);
+    double tDev = seconds(start);
+    start = std::chrono::steady_clock::now();
+    alignBatchHost(pack, pairs, s, scoresHost);
+    double tHost = seconds(start);
+
+    int mismatch = 0;
+    for (int p = 0; p < P; p++)
+        mismatch += scoresDev[p] != scoresHost[p];
+    bad += mismatch;
+    std::cout << "Pairs: " << P << ", cells: " << cells << "\n";
+    std::cout << "Device: " << tDev << " s, " << cells / tDev * 1e-9 << " GCUPS\n";
+    std::cout << "Host:   " << tHost << " s, " << cells / tHost * 1e-9 << " GCUPS\n";
+    std::cout << "Mismatches: " << mismatch << std::endl;
+
+    return bad != 0;
+}
@@ -0,0 +1,727 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "clRuntime.hpp"
+#include "LCSbatch.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+    Pairwise alignment next to the LCS engines: Smith-Waterman (local), Needleman-Wunsch (global),
+    edit distance, with a substitution matrix & affine gaps (gap of k: gapOpen + (k - 1) * gapExtend, Gotoh)
+        E(i, j) = max(E(i, j - 1) - ext, H(i, j - 1) - open)        gap in A (consumes b_j)
+        F(i, j) = max(F(i - 1, j) - ext, H(i - 1, j) - open)        gap in B (consumes a_i)
+        H(i, j) = max(H(i - 1, j - 1) + S(a_i, b_j), E, F [, 0 local])
+    LCS = global, match 1, mismatch 0, no gap cost. Edit distance = -global, match 0, mismatch -1, gaps 1 / 1.
+
+    Score: Farrar's striped query profile. A is cut into L segments, 1 per SIMD lane: lane l holds rows
+    l * segLen + s, so the in-column dependency runs down a lane and only crosses lanes once per column
+    (the lazy-F loop, usually 0 or 1 extra pass). The profile S(a_i, c) per char c is built once per query.
+    Lanes (SSE2, portable loops elsewhere): 16 x u8 biased saturating (local only), 8 x i16 saturating.
+    Saturation is caught from the max / min lane and the pair is redone 8 -> 16 -> 32-bit scalar.
+    Traceback: 32-bit scalar, 1 direction byte per cell. Batches: 1 work-item per pair on the device (inter-task).
+*/
+
+#define ALIGN_NEG (-(1 << 29)) // -inf of the 32-bit paths, far from int overflow after subtractions
+#define ALIGN_BATCH_WG 64
+
+enum AlignMode { ALIGN_LOCAL, ALIGN_GLOBAL };
+
+struct AlignScoring {
+    AlignMode mode = ALIGN_LOCAL;
+    int gapOpen = 11, gapExtend = 1; // gapExtend <= gapOpen
+    int alpha = 0;              // matrix is alpha x alpha
+    std::vector<int8_t> matrix;
+    uint8_t code[256] = {};     // char -> matrix row / column
+    int lo = 0, hi = 0;         // smallest & largest entry
+
+    int score(char a, char b) const { return matrix[code[(unsigned char)a] * alpha + code[(unsigned char)b]]; }
+};
+
+// scores: alpha x alpha over the chars of alphabet. Other chars are scored as alphabet[unknown]
+inline AlignScoring alignMatrix(std::string_view alphabet, const int8_t* scores, int unknown, int gapOpen, int gapExtend,
+                                AlignMode mode, bool ignoreCase = false) {
+    AlignScoring s;
+    s.mode = mode;
+    s.gapOpen = gapOpen;
+    s.gapExtend = gapExtend;
+    s.alpha = alphabet.size();
+    s.matrix.assign(scores, scores + s.alpha * s.alpha);
+    std::memset(s.code, unknown, sizeof(s.code));
+    for (int k = 0; k < s.alpha; k++) {
+        unsigned char c = alphabet[k];
+        s.code[c] = k;
+        if (ignoreCase)
+            s.code[tolower(c)] = s.code[toupper(c)] = k;
+    }
+    s.lo = *std::min_element(s.matrix.begin(), s.matrix.end());
+    s.hi = *std::max_element(s.matrix.begin(), s.matrix.end());
+    return s;
+}
+
+// match / mismatch over alphabet + 1 wildcard for every other char (mismatch even with itself)
+inline AlignScoring alignSimple(int match, int mismatch, int gapOpen, int gapExtend, AlignMode mode,
+                                std::string_view alphabet = "ACGT") {
+    int a = alphabet.size() + 1;
+    std::vector<int8_t> m(a * a, mismatch);
+    for (int k = 0; k + 1 < a; k++)
+        m[k * a + k] = match;
+    return alignMatrix(std::string(alphabet) + '\0', m.data(), a - 1, gapOpen, gapExtend, mode);
+}
+
+inline AlignScoring alignBlosum62(int gapOpen = 11, int gapExtend = 1, AlignMode mode = ALIGN_LOCAL) {
+    static const int8_t b62[24 * 24] = {
+         4, -1, -2, -2,  0, -1, -1,  0, -2, -1, -1, -1, -1, -2, -1,  1,  0, -3, -2,  0, -2, -1,  0, -4,
+        -1,  5,  0, -2, -3,  1,  0, -2,  0, -3, -2,  2, -1, -3, -2, -1, -1, -3, -2, -3, -1,  0, -1, -4,
+        -2,  0,  6,  1, -3,  0,  0,  0,  1, -3, -3,  0, -2, -3, -2,  1,  0, -4, -2, -3,  3,  0, -1, -4,
+        -2, -2,  1,  6, -3,  0,  2, -1, -1, -3, -4, -1, -3, -3, -1,  0, -1, -4, -3, -3,  4,  1, -1, -4,
+         0, -3, -3, -3,  9, -3, -4, -3, -3, -1, -1, -3, -1, -2, -3, -1, -1, -2, -2, -1, -3, -3, -2, -4,
+        -1,  1,  0,  0, -3,  5,  2, -2,  0, -3, -2,  1,  0, -3, -1,  0, -1, -2, -1, -2,  0,  3, -1, -4,
+        -1,  0,  0,  2, -4,  2,  5, -2,  0, -3, -3,  1, -2, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4,
+         0, -2,  0, -1, -3, -2, -2,  6, -2, -4, -4, -2, -3, -3, -2,  0, -2, -2, -3, -3, -1, -2, -1, -4,
+        -2,  0,  1, -1, -3,  0,  0, -2,  8, -3, -3, -1, -2, -1, -2, -1, -2, -2,  2, -3,  0,  0, -1, -4,
+        -1, -3, -3, -3, -1, -3, -3, -4, -3,  4,  2, -3,  1,  0, -3, -2, -1, -3, -1,  3, -3, -3, -1, -4,
+        -1, -2, -3, -4, -1, -2, -3, -4, -3,  2,  4, -2,  2,  0, -3, -2, -1, -2, -1,  1, -4, -3, -1, -4,
+        -1,  2,  0, -1, -3,  1,  1, -2, -1, -3, -2,  5, -1, -3, -1,  0, -1, -3, -2, -2,  0,  1, -1, -4,
+        -1, -1, -2, -3, -1,  0, -2, -3, -2,  1,  2, -1,  5,  0, -2, -1, -1, -1, -1,  1, -3, -1, -1, -4,
+        -2, -3, -3, -3, -2, -3, -3, -3, -1,  0,  0, -3,  0,  6, -4, -2, -2,  1,  3, -1, -3, -3, -1, -4,
+        -1, -2, -2, -1, -3, -1, -1, -2, -2, -3, -3, -1, -2, -4,  7, -1, -1, -4, -3, -2, -2, -1, -2, -4,
+         1, -1,  1,  0, -1,  0,  0,  0, -1, -2, -2,  0, -1, -2, -1,  4,  1, -3, -2, -2,  0,  0,  0, -4,
+         0, -1,  0, -1, -1, -1, -1, -2, -2, -1, -1, -1, -1, -2, -1,  1,  5, -2, -2,  0, -1, -1,  0, -4,
+        -3, -3, -4, -4, -2, -2, -3, -2, -2, -3, -2, -3, -1,  1, -4, -3, -2, 11,  2, -3, -4, -3, -2, -4,
+        -2, -2, -2, -3, -2, -1, -2, -3,  2, -1, -1, -2, -1,  3, -3, -2, -2,  2,  7, -1, -3, -2, -1, -4,
+         0, -3, -3, -3, -1, -2, -2, -3, -3,  3,  1, -2,  1, -1, -2, -2,  0, -3, -1,  4, -3, -2, -1, -4,
+        -2, -1,  3,  4, -3,  0,  1, -1,  0, -3, -4,  0, -3, -3, -2,  0, -1, -4, -3, -3,  4,  1, -1, -4,
+        -1,  0,  0,  1, -3,  3,  4, -2,  0, -3, -3,  1, -1, -3, -1,  0, -1, -3, -2, -2,  1,  4, -1, -4,
+         0, -1, -1, -1, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -2,  0,  0, -2, -1, -1, -1, -1, -1, -4,
+        -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1,
+    };
+    return alignMatrix("ARNDCQEGHILKMFPSTWYVBZX*", b62, 22, gapOpen, gapExtend, mode, true); // unknown: X
+}
+
+// Distinct chars of a & b: a wildcard-free alphabet for alignSimple over arbitrary text
+inline std::string alignAlphabet(std::string_view a, std::string_view b) {
+    bool seen[256] = {};
+    std::string alphabet;
+    for (std::string_view s : { a, b })
+        for (unsigned char c : s)
+            if (!seen[c]) {
+                seen[c] = true;
+                alphabet += c;
+            }
+    return alphabet;
+}
+
+inline AlignScoring alignLcsScoring(std::string_view alphabet) { return alignSimple(1, 0, 0, 0, ALIGN_GLOBAL, alphabet); }
+inline AlignScoring alignEditScoring(std::string_view alphabet) { return alignSimple(0, -1, 1, 1, ALIGN_GLOBAL, alphabet); }
+
+
+
+// ------ Scalar ------
+// 32-bit Gotoh over 1 row: the reference & the last resort of the striped engine
+inline int alignScalar(std::string_view a, std::string_view b, const AlignScoring& s) {
+    size_t m = a.size(), n = b.size();
+    bool local = s.mode == ALIGN_LOCAL;
+    std::vector<int> H(n + 1), F(n + 1, ALIGN_NEG);
+    for (size_t j = 1; j <= n; j++)
+        H[j] = local ? 0 : -(s.gapOpen + (int)(j - 1) * s.gapExtend);
+    int best = 0;
+    for (size_t i = 1; i <= m; i++) {
+        const int8_t* row = &s.matrix[s.code[(unsigned char)a[i - 1]] * s.alpha];
+        int diag = H[0];
+        H[0] = local ? 0 : -(s.gapOpen + (int)(i - 1) * s.gapExtend);
+        int e = ALIGN_NEG;
+        for (size_t j = 1; j <= n; j++) {
+            e = std::max(e - s.gapExtend, H[j - 1] - s.gapOpen);
+            F[j] = std::max(F[j] - s.gapExtend, H[j] - s.gapOpen);
+            int h = std::max(diag + row[s.code[(unsigned char)b[j - 1]]], std::max(e, F[j]));
+            if (local)
+                h = std::max(h, 0);
+            diag = H[j];
+            H[j] = h;
+            best = std::max(best, h);
+        }
+    }
+    return local ? best : H[n];
+}
+
+
+
+// ------ Lane ops ------
+// V: L lanes of T, saturating. NEG: -inf of the lane type, biased: unsigned lanes offset by the profile bias
+#if defined(__SSE2__)
+struct AlignU8 {
+    using V = __m128i;
+    static constexpr int L = 16, NEG = 0, MAXV = 255;
+    static constexpr bool biased = true;
+    static V make(const int* v) {
+        alignas(16) uint8_t t[L];
+        for (int l = 0; l < L; l++)
+            t[l] = std::clamp(v[l], NEG, MAXV);
+        return _mm_load_si128((const V*)t);
+    }
+    static V set1(int x) { return _mm_set1_epi8((char)std::clamp(x, NEG, MAXV)); }
+    static V adds(V a, V b) { return _mm_adds_epu8(a, b); }
+    static V subs(V a, V b) { return _mm_subs_epu8(a, b); }
+    static V max(V a, V b) { return _mm_max_epu8(a, b); }
+    static V min(V a, V b) { return _mm_min_epu8(a, b); }
+    // no unsigned compare in SSE2: a > b <=> a -sat b != 0
+    static bool anyGt(V a, V b) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(a, b), _mm_setzero_si128())) != 0xFFFF;
+    }
+    // lane l -> l + 1, x into lane 0
+    static V shift(V v, int x) { return _mm_or_si128(_mm_slli_si128(v, 1), _mm_cvtsi32_si128(std::clamp(x, NEG, MAXV))); }
+    static int lane(V v, int l) {
+        alignas(16) uint8_t t[L];
+        _mm_store_si128((V*)t, v);
+        return t[l];
+    }
+};
+
+struct AlignI16 {
+    using V = __m128i;
+    static constexpr int L = 8, NEG = INT16_MIN, MAXV = INT16_MAX;
+    static constexpr bool biased = false;
+    static V make(const int* v) {
+        alignas(16) int16_t t[L];
+        for (int l = 0; l < L; l++)
+            t[l] = std::clamp(v[l], NEG, MAXV);
+        return _mm_load_si128((const V*)t);
+    }
+    static V set1(int x) { return _mm_set1_epi16((short)std::clamp(x, NEG, MAXV)); }
+    static V adds(V a, V b) { return _mm_adds_epi16(a, b); }
+    static V subs(V a, V b) { return _mm_subs_epi16(a, b); }
+    static V max(V a, V b) { return _mm_max_epi16(a, b); }
+    static V min(V a, V b) { return _mm_min_epi16(a, b); }
+    static bool anyGt(V a, V b) { return _mm_movemask_epi8(_mm_cmpgt_epi16(a, b)) != 0; }
+    static V shift(V v, int x) { return _mm_insert_epi16(_mm_slli_si128(v, 2), std::clamp(x, NEG, MAXV), 0); }
+    static int lane(V v, int l) {
+        alignas(16) int16_t t[L];
+        _mm_store_si128((V*)t, v);
+        return t[l];
+    }
+};
+#else
+// Same contract in plain loops (the compiler vectorises what it can)
+template <typename T, int N, int LO, int HI, bool B>
+struct AlignLanes {
+    struct V {
+        T x[N];
+    };
+    static constexpr int L = N, NEG = LO, MAXV = HI;
+    static constexpr bool biased = B;
+    static V make(const int* v) {
+        V r;
+        for (int l = 0; l < L; l++)
+            r.x[l] = std::clamp(v[l], NEG, MAXV);
+        return r;
+    }
+    static V set1(int x) {
+        V r;
+        for (int l = 0; l < L; l++)
+            r.x[l] = std::clamp(x, NEG, MAXV);
+        return r;
+    }
+    static V adds(V a, V b) {
+        for (int l = 0; l < L; l++)
+            a.x[l] = std::clamp(a.x[l] + b.x[l], NEG, MAXV);
+        return a;
+    }
+    static V subs(V a, V b) {
+        for (int l = 0; l < L; l++)
+            a.x[l] = std::clamp(a.x[l] - b.x[l], NEG, MAXV);
+        return a;
+    }
+    static V max(V a, V b) {
+        for (int l = 0; l < L; l++)
+            a.x[l] = std::max(a.x[l], b.x[l]);
+        return a;
+    }
+    static V min(V a, V b) {
+        for (int l = 0; l < L; l++)
+            a.x[l] = std::min(a.x[l], b.x[l]);
+        return a;
+    }
+    static bool anyGt(V a, V b) {
+        bool gt = false;
+        for (int l = 0; l < L; l++)
+            gt |= a.x[l] > b.x[l];
+        return gt;
+    }
+    static V shift(V v, int x) {
+        for (int l = L - 1; l > 0; l--)
+            v.x[l] = v.x[l - 1];
+        v.x[0] = std::clamp(x, NEG, MAXV);
+        return v;
+    }
+    static int lane(V v, int l) { return v.x[l]; }
+};
+using AlignU8 = AlignLanes<uint8_t, 16, 0, 255, true>;
+using AlignI16 = AlignLanes<int16_t, 8, INT16_MIN, INT16_MAX, false>;
+#endif
+
+
+
+// ------ Striped profile ------
+// Query a (as matrix codes) striped over Ops::L lanes; run() scores 1 target, false on saturation
+template <typename Ops>
+class AlignProfile {
+public:
+    using V = typename Ops::V;
+    struct Slot { // vector<__m128i> drops the type's attributes (-Wignored-attributes)
+        V v;
+    };
+
+    AlignProfile(const std::vector<uint8_t>& a, const AlignScoring& s)
+        : s_(s), m_(a.size()), seg_((a.size() + Ops::L - 1) / Ops::L), prof_(s.alpha * seg_) {
+        bool local = s.mode == ALIGN_LOCAL;
+        bias_ = Ops::biased ? std::max(0, -s.lo) : 0;
+        // Rows past m: never above the real ones (local) / only there to be ignored (global)
+        int pad = local ? std::min(s.lo, -1) : 0;
+        int lanes[Ops::L];
+        for (int c = 0; c < s.alpha; c++)
+            for (size_t k = 0; k < seg_; k++) {
+                for (int l = 0; l < Ops::L; l++) {
+                    size_t i = l * seg_ + k;
+                    lanes[l] = (i < m_ ? s.matrix[a[i] * s.alpha + c] : pad) + bias_;
+                }
+                prof_[c * seg_ + k].v = Ops::make(lanes);
+            }
+    }
+
+    bool run(const uint8_t* b, size_t n, int& score) const {
+        const bool local = s_.mode == ALIGN_LOCAL;
+        const int open = s_.gapOpen, ext = s_.gapExtend;
+        // global boundaries H(0, j) / H(i, 0) must fit too
+        if (!local && (long)open + (long)(std::max(m_, n) + Ops::L) * ext >= Ops::MAXV / 2)
+            return false;
+        auto edge = [&](size_t k) { return k == 0 ? 0 : -(open + (int)(k - 1) * ext); };
+
+        std::vector<Slot> hA(seg_), hB(seg_), e(seg_);
+        Slot* hLoad = hA.data();
+        Slot* hStore = hB.data();
+        int lanesH[Ops::L], lanesE[Ops::L];
+        for (size_t k = 0; k < seg_; k++) { // column 0, E(i, 1) = H(i, 0) - open
+            for (int l = 0; l < Ops::L; l++) {
+                lanesH[l] = local ? 0 : edge(l * seg_ + k + 1);
+                lanesE[l] = local ? Ops::NEG : lanesH[l] - open;
+            }
+            hStore[k].v = Ops::make(lanesH);
+            e[k].v = Ops::make(lanesE);
+        }
+        const V vOpen = Ops::set1(open), vExt = Ops::set1(ext), vBias = Ops::set1(bias_);
+        const V vZero = Ops::set1(0), vNeg = Ops::set1(Ops::NEG);
+        V vMax = vNeg, vMin = Ops::set1(Ops::MAXV);
+
+        for (size_t j = 1; j <= n; j++) {
+            const Slot* p = &prof_[b[j - 1] * seg_];
+            int fTop = local ? Ops::NEG : edge(j) - open; // F(1, j)
+            V vF = Ops::shift(vNeg, fTop);
+            V vH = Ops::shift(hStore[seg_ - 1].v, local ? 0 : edge(j - 1)); // diagonal of segment 0
+            std::swap(hLoad, hStore);
+            for (size_t k = 0; k < seg_; k++) {
+                vH = Ops::biased ? Ops::subs(Ops::adds(vH, p[k].v), vBias) : Ops::adds(vH, p[k].v);
+                V vE = e[k].v;
+                vH = Ops::max(Ops::max(vH, vE), vF);
+                if (local && !Ops::biased)
+                    vH = Ops::max(vH, vZero);
+                vMax = Ops::max(vMax, vH);
+                vMin = Ops::min(vMin, vH);
+                hStore[k].v = vH;
+                vH = Ops::subs(vH, vOpen);
+                e[k].v = Ops::max(Ops::subs(vE, vExt), vH);
+                vF = Ops::max(Ops::subs(vF, vExt), vH);
+                vH = hLoad[k].v;
+            }
+            // Lazy F: carry F from the bottom of lane l into lane l + 1 until it no longer beats H - open
+            bool done = false;
+            for (int pass = 0; pass < Ops::L && !done; pass++) {
+                vF = Ops::shift(vF, fTop);
+                for (size_t k = 0; k < seg_; k++) {
+                    V vOld = hStore[k].v;
+                    V vNew = Ops::max(vOld, vF);
+                    hStore[k].v = vNew;
+                    vMax = Ops::max(vMax, vNew);
+                    e[k].v = Ops::max(e[k].v, Ops::subs(vNew, vOpen));
+                    vF = Ops::subs(vF, vExt);
+                    if (!Ops::anyGt(vF, Ops::subs(vOld, vOpen))) {
+                        done = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        int hi = Ops::NEG, lo = Ops::MAXV;
+        for (int l = 0; l < Ops::L; l++) {
+            hi = std::max(hi, Ops::lane(vMax, l));
+            lo = std::min(lo, Ops::lane(vMin, l));
+        }
+        if (hi + bias_ + s_.hi >= Ops::MAXV)
+            return false;
+        if (local) {
+            score = hi;
+            return true;
+        }
+        if (lo <= Ops::NEG + open + ext - s_.lo)
+            return false;
+        score = Ops::lane(hStore[(m_ - 1) % seg_].v, (m_ - 1) / seg_);
+        return true;
+    }
+
+private:
+    AlignScoring s_;
+    size_t m_, seg_;
+    int bias_ = 0;
+    std::vector<Slot> prof_; // alpha x segLen
+};
+
+
+
+// ------ Query ------
+struct AlignScore {
+    int score = 0;
+    int bits = 0; // lane width that produced it: 8, 16 or 32 (scalar)
+};
+
+// 1 query against any number of targets: profiles are built on first use and kept
+class AlignQuery {
+public:
+    AlignQuery(std::string_view a, const AlignScoring& s) : a_(a), s_(s), codes_(encode(a)) {}
+
+    AlignScore score(std::string_view b) {
+        if (a_.empty() || b.empty())
+            return { alignScalar(a_, b, s_), 32 };
+        std::vector<uint8_t> bc = encode(b);
+        int r;
+        if (s_.mode == ALIGN_LOCAL) {
+            if (!p8_)
+                p8_ = std::make_unique<AlignProfile<AlignU8>>(codes_, s_);
+            if (p8_->run(bc.data(), bc.size(), r))
+                return { r, 8 };
+        }
+        if (!p16_)
+            p16_ = std::make_unique<AlignProfile<AlignI16>>(codes_, s_);
+        if (p16_->run(bc.data(), bc.size(), r))
+            return { r, 16 };
+        return { alignScalar(a_, b, s_), 32 };
+    }
+
+    const AlignScoring& scoring() const { return s_; }
+
+private:
+    std::vector<uint8_t> encode(std::string_view x) const {
+        std::vector<uint8_t> c(x.size());
+        for (size_t i = 0; i < x.size(); i++)
+            c[i] = s_.code[(unsigned char)x[i]];
+        return c;
+    }
+
+    std::string a_;
+    AlignScoring s_;
+    std::vector<uint8_t> codes_;
+    std::unique_ptr<AlignProfile<AlignU8>> p8_;
+    std::unique_ptr<AlignProfile<AlignI16>> p16_;
+};
+
+inline AlignScore alignScore(std::string_view a, std::string_view b, const AlignScoring& s) {
+    return AlignQuery(a, s).score(b);
+}
+
+inline int editDistance(std::string_view a, std::string_view b) {
+    return -alignScore(a, b, alignEditScoring(alignAlphabet(a, b))).score;
+}
+
+
+
+// ------ Traceback ------
+struct Alignment {
+    int score = 0;
+    size_t aBegin = 0, aEnd = 0, bBegin = 0, bEnd = 0; // aligned ranges [begin, end)
+    std::string cigar;                                 // M: a_i over b_j, I: a_i over a gap, D: a gap over b_j
+    std::string rowA, rowB;                            // gapped rows, '-' in gaps
+};
+
+// Keeps 1 direction byte per cell: (m + 1) * (n + 1) bytes
+inline Alignment alignTrace(std::string_view a, std::string_view b, const AlignScoring& s) {
+    size_t m = a.size(), n = b.size(), w = n + 1;
+    bool local = s.mode == ALIGN_LOCAL;
+    int open = s.gapOpen, ext = s.gapExtend;
+    // bits 0-1: H from 0 diagonal / 1 E / 2 F / 3 start of a local alignment, bit 2: E extends, bit 3: F extends
+    std::vector<uint8_t> tb((m + 1) * w, 3);
+    std::vector<int> H(w), F(w, ALIGN_NEG);
+    for (size_t j = 1; j <= n; j++)
+        H[j] = local ? 0 : -(open + (int)(j - 1) * ext);
+    int best = 0;
+    size_t bi = 0, bj = 0;
+    for (size_t i = 1; i <= m; i++) {
+        int diag = H[0];
+        H[0] = local ? 0 : -(open + (int)(i - 1) * ext);
+        int e = ALIGN_NEG;
+        uint8_t* t = &tb[i * w];
+        for (size_t j = 1; j <= n; j++) {
+            uint8_t bits = 0;
+            if (e - ext > H[j - 1] - open)
+                bits |= 4;
+            e = std::max(e - ext, H[j - 1] - open);
+            if (F[j] - ext > H[j] - open)
+                bits |= 8;
+            F[j] = std::max(F[j] - ext, H[j] - open);
+            int h = diag + s.score(a[i - 1], b[j - 1]);
+            int src = 0;
+            if (e > h) {
+                h = e;
+                src = 1;
+            }
+            if (F[j] > h) {
+                h = F[j];
+                src = 2;
+            }
+            if (local && h <= 0) {
+                h = 0;
+                src = 3;
+            }
+            diag = H[j];
+            H[j] = h;
+            t[j] = bits | src;
+            if (local && h > best) {
+                best = h;
+                bi = i;
+                bj = j;
+            }
+        }
+    }
+
+    Alignment r;
+    r.score = local ? best : H[n];
+    size_t i = local ? bi : m, j = local ? bj : n;
+    r.aEnd = i;
+    r.bEnd = j;
+    std::string ops;
+    int state = 0; // in H / E / F
+    while (i > 0 || j > 0) {
+        if (i == 0 || j == 0) { // global edges: 1 gap to the corner
+            if (local)
+                break;
+            ops += i == 0 ? 'D' : 'I';
+            (i == 0 ? j : i)--;
+            continue;
+        }
+        uint8_t t = tb[i * w + j];
+        if (state == 0) {
+            if ((t & 3) == 3)
+                break;
+            if ((t & 3) == 0) {
+                ops += 'M';
+                i--;
+                j--;
+            }
+            else
+                state = t & 3;
+        }
+        else if (state == 1) {
+            ops += 'D';
+            state = t & 4 ? 1 : 0;
+            j--;
+        }
+        else {
+            ops += 'I';
+            state = t & 8 ? 2 : 0;
+            i--;
+        }
+    }
+    r.aBegin = i;
+    r.bBegin = j;
+    std::reverse(ops.begin(), ops.end());
+
+    for (size_t k = 0; k < ops.size();) {
+        size_t run = 1;
+        while (k + run < ops.size() && ops[k + run] == ops[k])
+            run++;
+        r.cigar += std::to_string(run) + ops[k];
+        k += run;
+    }
+    for (char o : ops) {
+        r.rowA += o == 'D' ? '-' : a[i++];
+        r.rowB += o == 'I' ? '-' : b[j++];
+    }
+    return r;
+}
+
+// Identical pairs along the alignment, lcsSeq's interface: with alignLcsScoring this is an LCS
+inline std::string alignSeq(std::string_view a, std::string_view b, const AlignScoring& s) {
+    Alignment r = alignTrace(a, b, s);
+    std::string seq;
+    size_t i = r.aBegin, j = r.bBegin;
+    for (size_t k = 0; k < r.cigar.size();) {
+        size_t run = strtoul(r.cigar.c_str() + k, nullptr, 10);
+        k = r.cigar.find_first_not_of("0123456789", k);
+        char o = r.cigar[k++];
+        for (size_t q = 0; q < run; q++) {
+            if (o == 'M' && a[i] == b[j])
+                seq += a[i];
+            i += o != 'D';
+            j += o != 'I';
+        }
+    }
+    return seq;
+}
+
+
+
+// ------ Batch ------
+// pairs: 2 ints per pair into the pack, as LCSBatch
+inline void alignBatchHost(const SeqPack& pack, const std::vector<int>& pairs, const AlignScoring& s,
+                           std::vector<int>& scores) {
+    int nPairs = pairs.size() / 2;
+    scores.resize(nPairs);
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int p = 0; p < nPairs; p++)
+        scores[p] = alignScore(pack[pairs[2 * p]], pack[pairs[2 * p + 1]], s).score;
+}
+
+inline const char* const alignBatchKern = R"(
+// 1 work-item per pair (inter-task), 32-bit Gotoh over 1 row. The rows of a work-group are interleaved
+// (cell j of work-item t at j * size + t): neighbouring work-items touch neighbouring words
+__kernel void align_batch(__global const uchar* seqs, __global const int* offs, __global const int2* pairs,
+                          __constant char* matrix, const int alpha, const int local_, const int gapOpen,
+                          const int gapExt, __global int* scratch, __global const long* groupOffs,
+                          __global int* scores, const int nPairs) {
+    int p = get_global_id(0);
+    if (p >= nPairs)
+        return;
+    const int NEG = -(1 << 29);
+    int g = get_group_id(0), stride = get_local_size(0);
+    __global int* H = scratch + groupOffs[g] + get_local_id(0);
+    __global int* F = H + (groupOffs[g + 1] - groupOffs[g]) / 2;
+    int2 pr = pairs[p];
+    __global const uchar* a = seqs + offs[pr.x];
+    __global const uchar* b = seqs + offs[pr.y];
+    int m = offs[pr.x + 1] - offs[pr.x];
+    int n = offs[pr.y + 1] - offs[pr.y];
+
+    H[0] = 0;
+    for (int j = 1; j <= n; j++) {
+        H[j * stride] = local_ ? 0 : -(gapOpen + (j - 1) * gapExt);
+        F[j * stride] = NEG;
+    }
+    int best = 0;
+    for (int i = 1; i <= m; i++) {
+        __constant char* row = matrix + a[i - 1] * alpha;
+        int diag = H[0];
+        int left = local_ ? 0 : -(gapOpen + (i - 1) * gapExt);
+        H[0] = left;
+        int e = NEG;
+        for (int j = 1; j <= n; j++) {
+            int up = H[j * stride];
+            int f = max(F[j * stride] - gapExt, up - gapOpen);
+            e = max(e - gapExt, left - gapOpen);
+            int h = max(diag + row[b[j - 1]], max(e, f));
+            if (local_)
+                h = max(h, 0);
+            F[j * stride] = f;
+            H[j * stride] = h;
+            diag = up;
+            left = h;
+            best = max(best, h);
+        }
+    }
+    scores[p] = local_ ? best : H[n * stride];
+}
+)";
+
+// Pairs run longest first (by m * n), so the work-items of a group finish together; each group's
+// 2 rows are sized by its longest b. Buffers come from the runtime's pool and only grow, as LCSBatch
+class AlignBatch {
+public:
+    explicit AlignBatch(ClRuntime& rt = ClRuntime::get()) : rt_(rt), qu_(rt.queue()) {
+        prog_ = rt_.program(alignBatchKern);
+        kern_ = cl::Kernel(prog_, "align_batch");
+        wg_ = std::min<size_t>(ALIGN_BATCH_WG, rt_.device().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+    }
+
+    void run(const SeqPack& pack, const std::vector<int>& pairs, const AlignScoring& s, std::vector<int>& scores) {
+        int nPairs = pairs.size() / 2;
+        scores.resize(nPairs);
+        if (nPairs == 0)
+            return;
+        auto len = [&](int k) { return (size_t)(pack.offs[k + 1] - pack.offs[k]); };
+
+        std::vector<int> order(nPairs);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](int x, int y) {
+            return len(pairs[2 * x]) * len(pairs[2 * x + 1]) > len(pairs[2 * y]) * len(pairs[2 * y + 1]);
+        });
+        std::vector<int> sorted(2 * nPairs);
+        for (int p = 0; p < nPairs; p++) {
+            sorted[2 * p] = pairs[2 * order[p]];
+            sorted[2 * p + 1] = pairs[2 * order[p] + 1];
+        }
+        size_t groups = (nPairs + wg_ - 1) / wg_;
+        std::vector<cl_long> groupOffs(groups + 1, 0);
+        for (size_t g = 0; g < groups; g++) {
+            size_t cols = 0;
+            for (size_t p = g * wg_; p < std::min<size_t>(nPairs, (g + 1) * wg_); p++)
+                cols = std::max(cols, len(sorted[2 * p + 1]) + 1);
+            groupOffs[g + 1] = groupOffs[g] + 2 * cols * wg_;
+        }
+        std::vector<uint8_t> codes(pack.seqs.size());
+        for (size_t k = 0; k < codes.size(); k++)
+            codes[k] = s.code[(unsigned char)pack.seqs[k]];
+
+        reserve(buf_seqs_, std::max<size_t>(1, codes.size()));
+        reserve(buf_offs_, sizeof(int) * pack.offs.size());
+        reserve(buf_pairs_, sizeof(int) * sorted.size());
+        reserve(buf_matrix_, s.matrix.size());
+        reserve(buf_scratch_, sizeof(int) * std::max<size_t>(1, groupOffs[groups]));
+        reserve(buf_groupOffs_, sizeof(cl_long) * groupOffs.size());
+        reserve(buf_scores_, sizeof(int) * nPairs);
+
+        if (!codes.empty())
+            qu_.enqueueWriteBuffer(*buf_seqs_, CL_FALSE, 0, codes.size(), codes.data());
+        qu_.enqueueWriteBuffer(*buf_offs_, CL_FALSE, 0, sizeof(int) * pack.offs.size(), pack.offs.data());
+        qu_.enqueueWriteBuffer(*buf_pairs_, CL_FALSE, 0, sizeof(int) * sorted.size(), sorted.data());
+        qu_.enqueueWriteBuffer(*buf_matrix_, CL_FALSE, 0, s.matrix.size(), s.matrix.data());
+        qu_.enqueueWriteBuffer(*buf_groupOffs_, CL_FALSE, 0, sizeof(cl_long) * groupOffs.size(), groupOffs.data());
+
+        kern_.setArg(0, *buf_seqs_);
+        kern_.setArg(1, *buf_offs_);
+        kern_.setArg(2, *buf_pairs_);
+        kern_.setArg(3, *buf_matrix_);
+        kern_.setArg(4, s.alpha);
+        kern_.setArg(5, (int)(s.mode == ALIGN_LOCAL));
+        kern_.setArg(6, s.gapOpen);
+        kern_.setArg(7, s.gapExtend);
+        kern_.setArg(8, *buf_scratch_);
+        kern_.setArg(9, *buf_groupOffs_);
+        kern_.setArg(10, *buf_scores_);
+        kern_.setArg(11, nPairs);
+        qu_.enqueueNDRangeKernel(kern_, cl::NullRange, cl::NDRange(groups * wg_), cl::NDRange(wg_));
+        std::vector<int> out(nPairs);
+        qu_.enqueueReadBuffer(*buf_scores_, CL_TRUE, 0, sizeof(int) * nPairs, out.data());
+        for (int p = 0; p < nPairs; p++)
+            scores[order[p]] = out[p];
+    }
+
+private:
+    void reserve(PooledBuffer& buf, size_t bytes) {
+        if (bytes > buf.capacity())
+            buf = rt_.pool().acquire(bytes);
+    }
+
+    ClRuntime& rt_;
+    cl::CommandQueue& qu_;
+    cl::Program prog_;
+    cl::Kernel kern_;
+    size_t wg_;
+
+    PooledBuffer buf_seqs_, buf_offs_, buf_pairs_, buf_matrix_, buf_scratch_, buf_groupOffs_, buf_scores_;
+};
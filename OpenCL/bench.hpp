@@ -0,0 +1,144 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+/*
+    Benchmark harness
+    benchRun(): warm-up calls, then reps timed calls. Each call returns its own time in s,
+    so kernels can report device time (profiling events) and host code wall time.
+    BenchRow: what ran (suite, variant, params) + work per call in the report unit (Gcells, MP, GB, Gadds),
+    rate = work / time: at the median and at the p99 time.
+    BenchReport: 1 console line per row, then CSV (*.csv) or JSON (anything else) for regression tracking.
+    BENCH_BASELINE=<old.csv>: rows whose median rate fell by more than BENCH_TOLERANCE % vs the baseline are listed.
+*/
+
+#define BENCH_WARMUP 2
+#define BENCH_REPS 10
+#define BENCH_TOLERANCE 10 // %
+
+struct BenchStats {
+    int reps = 0;
+    double median = 0, p99 = 0, min = 0, mean = 0; // s
+};
+
+template <typename F>
+BenchStats benchRun(F fn, int reps = BENCH_REPS, int warmup = BENCH_WARMUP) {
+    for (int r = 0; r < warmup; r++)
+        fn();
+    std::vector<double> t(std::max(1, reps));
+    double sum = 0;
+    for (double& x : t) {
+        x = fn();
+        sum += x;
+    }
+    std::sort(t.begin(), t.end());
+    BenchStats st;
+    st.reps = t.size();
+    st.median = t.size() % 2 ? t[t.size() / 2] : 0.5 * (t[t.size() / 2 - 1] + t[t.size() / 2]);
+    st.p99 = t[std::min(t.size() - 1, (size_t)(0.99 * t.size()))]; // nearest rank
+    st.min = t[0];
+    st.mean = sum / t.size();
+    return st;
+}
+
+// Wall time (s) of 1 call
+template <typename F>
+double wallTime(F fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct BenchRow {
+    std::string suite, variant, params, unit;
+    double work = 0; // per call, in unit x s
+    BenchStats st;
+
+    std::string key() const { return suite + "/" + variant + "/" + params; }
+    double rate() const { return work / st.median; }
+    double rateP99() const { return work / st.p99; }
+};
+
+class BenchReport {
+public:
+    void add(const BenchRow& r) {
+        rows_.push_back(r);
+        std::cout << std::left << std::setw(10) << r.suite << std::setw(22) << r.variant << std::setw(28) << r.params << std::right
+                  << std::fixed << std::setprecision(3)
+                  << " median " << std::setw(10) << r.st.median * 1e3 << " ms"
+                  << "  p99 " << std::setw(10) << r.st.p99 * 1e3 << " ms  "
+                  << std::setw(10) << r.rate() << " " << r.unit << std::defaultfloat << std::endl;
+    }
+
+    void write(const std::string& path, const std::string& device) const {
+        std::ofstream out(path);
+        bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+        out << std::setprecision(9);
+        if (csv) {
+            out << "suite,variant,params,reps,median_ms,p99_ms,min_ms,mean_ms,rate,rate_p99,unit\n";
+            for (const BenchRow& r : rows_)
+                out << r.suite << ',' << r.variant << ',' << r.params << ',' << r.st.reps << ','
+                    << r.st.median * 1e3 << ',' << r.st.p99 * 1e3 << ',' << r.st.min * 1e3 << ',' << r.st.mean * 1e3 << ','
+                    << r.rate() << ',' << r.rateP99() << ',' << r.unit << '\n';
+        }
+        else {
+            out << "{\n  \"device\": \"" << device << "\",\n  \"results\": [";
+            for (size_t i = 0; i < rows_.size(); i++) {
+                const BenchRow& r = rows_[i];
+                out << (i ? ",\n" : "\n") << "    {\"suite\": \"" << r.suite << "\", \"variant\": \"" << r.variant
+                    << "\", \"params\": \"" << r.params << "\", \"reps\": " << r.st.reps
+                    << ", \"median_ms\": " << r.st.median * 1e3 << ", \"p99_ms\": " << r.st.p99 * 1e3
+                    << ", \"min_ms\": " << r.st.min * 1e3 << ", \"mean_ms\": " << r.st.mean * 1e3
+                    << ", \"rate\": " << r.rate() << ", \"rate_p99\": " << r.rateP99() << ", \"unit\": \"" << r.unit << "\"}";
+            }
+            out << "\n  ]\n}\n";
+        }
+        std::cout << "Results written to " << path << std::endl;
+    }
+
+    // Rows slower than a CSV written by write(): median rate below baseline by > tolerance %
+    int compare(const std::string& baseline, double tolerance = BENCH_TOLERANCE) const {
+        std::ifstream in(baseline);
+        if (!in) {
+            std::cerr << "Cannot read baseline " << baseline << std::endl;
+            return 0;
+        }
+        std::map<std::string, double> base;
+        std::string line;
+        std::getline(in, line); // header
+        while (std::getline(in, line)) {
+            std::vector<std::string> f;
+            std::stringstream ss(line);
+            for (std::string c; std::getline(ss, c, ',');)
+                f.push_back(c);
+            if (f.size() >= 9)
+                base[f[0] + "/" + f[1] + "/" + f[2]] = atof(f[8].c_str());
+        }
+
+        int regressions = 0;
+        for (const BenchRow& r : rows_) {
+            auto it = base.find(r.key());
+            if (it == base.end() || it->second <= 0)
+                continue;
+            double change = (r.rate() / it->second - 1) * 100;
+            if (change < -tolerance) {
+                std::cout << "REGRESSION " << r.key() << ": " << r.rate() << " vs " << it->second << " " << r.unit
+                          << " (" << std::fixed << std::setprecision(1) << change << std::defaultfloat << " %)" << std::endl;
+                regressions++;
+            }
+        }
+        std::cout << regressions << " regression(s) vs " << baseline << std::endl;
+        return regressions;
+    }
+
+private:
+    std::vector<BenchRow> rows_;
+};
@@ -0,0 +1,359 @@
+#include <CL/cl2.hpp>
+#include <omp.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "bench.hpp"
+#include "LCShirschberg.hpp"
+#include "LCSbitpar.hpp"
+#include "LCSpara.hpp"
+#include "LCSbatch.hpp"
+#include "zernikeKernels.hpp"
+#include "clExpr.hpp"
+#include "vecStream.hpp"
+
+/*
+    Benchmark suite: every implementation, swept over input sizes & thread / work-group counts
+    ./benchSuite [all|lcs|zernike|vecadd|omp] [results.csv|results.json] [reps] [image]
+    g++ -O2 -fopenmp -mavx2 benchSuite.cpp LCSorig.cpp -o benchSuite -lOpenCL $(pkg-config --cflags --libs opencv4)
+
+    lcs:     lcs() (LCSorig.cpp), bit-parallel (LCSbitpar.hpp), OpenCL wavefront (LCSpara.hpp),
+             OpenCL batch vs its OpenMP host fallback (LCSbatch.hpp): GCUPS, wall time
+    zernike: flat / tiled / image kernels on a real image, 3 scales x window N x work-group tile: MP/s, kernel time
+    vecadd:  kern0 (openCLTutor.cpp) & _3arrAdd (_3arrayAdd.cpp), sizes x work-group sizes,
+             + A + B + C as a fused expression (clExpr.hpp): GB/s, kernel time
+             + chunked int4 / int8 stream from host arrays (vecStream.hpp): GB/s, wall time
+    omp:     the sum of openMPmulTh.c, sequential / reduction / ordered over thread counts: Gadds/s
+    BENCH_WARMUP calls, then reps timed calls per row (median & p99). Every variant is checked against the first.
+    BENCH_BASELINE=<old.csv>: exit code 1 on rows slower than the baseline by > BENCH_TOLERANCE %
+*/
+
+#define LCS_ORIG_MAX 2048  // lcs() keeps the full table: larger sizes only for the linear-space engines
+#define LCS_BATCH_PAIRS 2000
+#define LCS_BATCH_LEN 256
+#define OMP_SUM_N (1 << 24)
+#define STREAM_N (1 << 25)
+
+std::string lcs(const std::string& a, const std::string& b, int m, int n); // LCSorig.cpp
+
+// Same kernels as openCLTutor.cpp (kern0) & _3arrayAdd.cpp (_3arrAdd)
+const char* vecAddKern = R"(
+ __kernel void kern0(global const int* A, global const int* B, global int* C) {
+    int i = get_global_id(0);
+    C[i] = A[i] + B[i];
+}
+
+ __kernel void _3arrAdd(global const int* A, global const int* B, global const int* C, global int* D) {
+    int i = get_global_id(0);
+    D[i] = A[i] + B[i] + C[i];
+}
+)";
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "MISMATCH: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Device time (s) of 1 finished command
+static double eventSeconds(const cl::Event& ev) {
+    ev.wait();
+    return (ev.getProfilingInfo<CL_PROFILING_COMMAND_END>() - ev.getProfilingInfo<CL_PROFILING_COMMAND_START>()) * 1e-9;
+}
+
+// 1, 2, 4, ... up to & including the max. thread count
+static std::vector<int> threadCounts() {
+    std::vector<int> t;
+    int max = omp_get_max_threads();
+    for (int k = 1; k < max; k *= 2)
+        t.push_back(k);
+    t.push_back(max);
+    return t;
+}
+
+static std::string randomSeq(std::mt19937& gen, int len) {
+    std::string s(len, ' ');
+    for (char& c : s)
+        c = "ACGT"[gen() % 4];
+    return s;
+}
+
+
+
+// ------ LCS ------
+static void benchLcs(BenchReport& report, ClRuntime& rt, int reps) {
+    std::mt19937 gen(1);
+    LCSWavefront wave(rt);
+    for (int n : { 512, 2048, 8192 }) {
+        std::string A = randomSeq(gen, n), B = randomSeq(gen, n);
+        std::string params = "n=" + std::to_string(n);
+        double gcells = (double)n * n * 1e-9;
+
+        int ref = LCSBitpar(A).length(B);
+        if (n <= LCS_ORIG_MAX) {
+            std::string s;
+            report.add({ "lcs", "orig", params, "GCUPS", gcells,
+                         benchRun([&] { return wallTime([&] { s = lcs(A, B, n, n); }); }, reps) });
+            check((int)s.size() == ref, "lcs() " + params);
+        }
+
+        int len = 0;
+        report.add({ "lcs", "bitpar", params, "GCUPS", gcells,
+                     benchRun([&] { return wallTime([&] { len = LCSBitpar(A).length(B); }); }, reps) });
+
+        if (LCSWavefront::boundaryBytes(n, n) <= lcsMemBudget()) {
+            report.add({ "lcs", "ocl-wavefront", params + ";tile=" + std::to_string(TILE), "GCUPS", gcells,
+                         benchRun([&] { len = wave.run(A, B); return wave.seconds(); }, reps) });
+            check(len == ref, "wavefront " + params);
+        }
+    }
+
+    // Many short pairs: device batch vs host fallback over thread counts
+    SeqPack pack;
+    std::vector<int> pairs;
+    for (int p = 0; p < LCS_BATCH_PAIRS; p++) {
+        pairs.push_back(pack.add(randomSeq(gen, LCS_BATCH_LEN)));
+        pairs.push_back(pack.add(randomSeq(gen, LCS_BATCH_LEN)));
+    }
+    std::string params = "pairs=" + std::to_string(LCS_BATCH_PAIRS) + ";len=" + std::to_string(LCS_BATCH_LEN);
+    double gcells = (double)LCS_BATCH_PAIRS * LCS_BATCH_LEN * LCS_BATCH_LEN * 1e-9;
+    LCSBatch batch(rt);
+    std::vector<int> lensDev, lensHost;
+    report.add({ "lcs", "ocl-batch", params + ";wg=" + std::to_string(LCS_BATCH_WG), "GCUPS", gcells,
+                 benchRun([&] { return wallTime([&] { batch.run(pack, pairs, lensDev); }); }, reps) });
+    for (int t : threadCounts()) {
+        omp_set_num_threads(t);
+        report.add({ "lcs", "omp-batch", params + ";threads=" + std::to_string(t), "GCUPS", gcells,
+                     benchRun([&] { return wallTime([&] { lcsBatchHost(pack, pairs, lensHost); }); }, reps) });
+    }
+    omp_set_num_threads(threadCounts().back());
+    check(lensDev == lensHost, "ocl-batch vs omp-batch");
+}
+
+
+
+// ------ Zernike ------
+static void benchZernike(BenchReport& report, ClRuntime& rt, int reps, const std::string& imgPath) {
+    cv::Mat src = cv::imread(imgPath, cv::IMREAD_GRAYSCALE);
+    if (src.empty()) {
+        std::cerr << "Zernike: cannot load " << imgPath << ", skipped" << std::endl;
+        return;
+    }
+    cl::CommandQueue& qu = rt.queue();
+    const int order = 4;
+    const size_t tiles[][2] = { { 8, 8 }, { 16, 16 }, { 64, 4 } };
+
+    for (double scale : { 0.5, 1.0, 2.0 }) {
+        cv::Mat image;
+        cv::resize(src, image, cv::Size(src.cols * scale, src.rows * scale), 0, 0, scale < 1 ? cv::INTER_AREA : cv::INTER_LINEAR);
+        if (!image.isContinuous())
+            image = image.clone();
+        int width = image.cols, height = image.rows;
+        size_t pixels = (size_t)width * height;
+
+        PooledBuffer in = rt.pool().acquire(pixels, CL_MEM_READ_ONLY);
+        PooledBuffer out = rt.pool().acquire(pixels, CL_MEM_WRITE_ONLY);
+        qu.enqueueWriteBuffer(*in, CL_TRUE, 0, pixels, image.data);
+        std::vector<uchar> ref(pixels), res(pixels);
+
+        for (int N : { 5, 7, 9 }) {
+            float kThr = 0.1f, lThr = std::sqrt(2.0f) / N;
+            for (int t = 0; t < 3; t++) {
+                ZernikeKernels zk = zernikeKernels(rt, order, N, kThr, lThr, tiles[t][0], tiles[t][1]);
+                cl::Image2D img;
+                if (zk.imageSupport)
+                    img = cl::Image2D(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, cl::ImageFormat(CL_R, CL_UNORM_INT8),
+                                      width, height, image.step, image.data);
+                cl::NDRange tiled((width + zk.tx - 1) / zk.tx * zk.tx, (height + zk.ty - 1) / zk.ty * zk.ty);
+
+                // flat kernel ignores the tile: once per (scale, N)
+                for (int k = t == 0 ? 0 : 1; k < zk.count(); k++) {
+                    cl::Kernel& kern = zk.kernels[k];
+                    if (k == 2)
+                        kern.setArg(0, img);
+                    else
+                        kern.setArg(0, *in);
+                    kern.setArg(1, *out);
+                    kern.setArg(2, width);
+                    kern.setArg(3, height);
+                    std::string params = std::to_string(width) + "x" + std::to_string(height) + ";N=" + std::to_string(N) +
+                                         (k == 0 ? "" : ";wg=" + std::to_string(zk.tx) + "x" + std::to_string(zk.ty));
+                    report.add({ "zernike", zernikeKernelNames[k], params, "MP/s", pixels * 1e-6, benchRun([&] {
+                        cl::Event ev;
+                        qu.enqueueNDRangeKernel(kern, cl::NullRange, k == 0 ? cl::NDRange(width, height) : tiled,
+                                                k == 0 ? cl::NullRange : cl::NDRange(zk.tx, zk.ty), nullptr, &ev);
+                        return eventSeconds(ev);
+                    }, reps) });
+
+                    // tiled & image results within 1 LSB of flat (float summation order)
+                    qu.enqueueReadBuffer(*out, CL_TRUE, 0, pixels, k == 0 ? ref.data() : res.data());
+                    int maxDiff = 0;
+                    for (size_t i = 0; k > 0 && i < pixels; i++)
+                        maxDiff = std::max(maxDiff, std::abs(res[i] - ref[i]));
+                    check(maxDiff <= 1, std::string(zernikeKernelNames[k]) + " " + params);
+                }
+            }
+        }
+    }
+}
+
+
+
+// ------ Elementwise: kern0 & _3arrAdd ------
+static void benchVecAdd(BenchReport& report, ClRuntime& rt, int reps) {
+    cl::CommandQueue& qu = rt.queue();
+    cl::Program prog = rt.program(vecAddKern);
+    size_t maxWg = rt.device().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+
+    for (size_t n : { (size_t)1 << 16, (size_t)1 << 20, (size_t)1 << 24 }) {
+        size_t bytes = n * sizeof(int);
+        std::vector<int> A(n), B(n), C(n), D(n);
+        for (size_t i = 0; i < n; i++) {
+            A[i] = i;
+            B[i] = 2 * i;
+            C[i] = 3 * i;
+        }
+        PooledBuffer pA = rt.pool().acquire(bytes, CL_MEM_READ_ONLY);
+        PooledBuffer pB = rt.pool().acquire(bytes, CL_MEM_READ_ONLY);
+        PooledBuffer pC = rt.pool().acquire(bytes, CL_MEM_READ_ONLY);
+        PooledBuffer pD = rt.pool().acquire(bytes, CL_MEM_WRITE_ONLY);
+        qu.enqueueWriteBuffer(*pA, CL_FALSE, 0, bytes, A.data());
+        qu.enqueueWriteBuffer(*pB, CL_FALSE, 0, bytes, B.data());
+        qu.enqueueWriteBuffer(*pC, CL_TRUE, 0, bytes, C.data());
+
+        cl::Kernel kern0(prog, "kern0"), add3(prog, "_3arrAdd");
+        kern0.setArg(0, *pA);
+        kern0.setArg(1, *pB);
+        kern0.setArg(2, *pD);
+        add3.setArg(0, *pA);
+        add3.setArg(1, *pB);
+        add3.setArg(2, *pC);
+        add3.setArg(3, *pD);
+
+        // wg 0: left to the runtime. n is a power of 2, so every size divides it
+        for (size_t wg : { (size_t)0, (size_t)64, (size_t)256 }) {
+            if (wg > maxWg)
+                continue;
+            std::string params = "n=" + std::to_string(n) + ";wg=" + (wg ? std::to_string(wg) : "auto");
+            cl::NDRange local = wg ? cl::NDRange(wg) : cl::NullRange;
+            auto run = [&](cl::Kernel& k) {
+                return benchRun([&] {
+                    cl::Event ev;
+                    qu.enqueueNDRangeKernel(k, cl::NullRange, cl::NDRange(n), local, nullptr, &ev);
+                    return eventSeconds(ev);
+                }, reps);
+            };
+            report.add({ "vecadd", "kern0", params, "GB/s", 3 * bytes * 1e-9, run(kern0) });
+            qu.enqueueReadBuffer(*pD, CL_TRUE, 0, bytes, D.data());
+            check(D[n - 1] == A[n - 1] + B[n - 1], "kern0 " + params);
+            report.add({ "vecadd", "_3arrAdd", params, "GB/s", 4 * bytes * 1e-9, run(add3) });
+            qu.enqueueReadBuffer(*pD, CL_TRUE, 0, bytes, D.data());
+            check(D[n - 1] == A[n - 1] + B[n - 1] + C[n - 1], "_3arrAdd " + params);
+        }
+
+        ClArray<int> a(A, rt), b(B, rt), c(C, rt), d(n, rt);
+        std::string params = "n=" + std::to_string(n) + ";width=" + std::to_string(clExprWidth<int>(rt.device()));
+        report.add({ "vecadd", "expr", params, "GB/s", 4 * bytes * 1e-9,
+                     benchRun([&] { return eventSeconds(clEval(d, a + b + c)); }, reps) });
+        check(d[n - 1] == A[n - 1] + B[n - 1] + C[n - 1], "expr " + params);
+    }
+
+    // Chunked & pipelined over 2 queues, end to end: host arrays -> mapped chunks -> host array
+    std::vector<int> A(STREAM_N), B(STREAM_N), C(STREAM_N), D(STREAM_N);
+    for (size_t i = 0; i < STREAM_N; i++) {
+        A[i] = i;
+        B[i] = 2 * i;
+        C[i] = 3 * i;
+    }
+    for (int vw : { 4, 8 }) {
+        VecStream stream(3, vw, STREAM_N / 8, rt); // 8 chunks
+        std::string params = "n=" + std::to_string(STREAM_N) + ";int" + std::to_string(vw) + ";chunk=" + std::to_string(stream.chunk());
+        report.add({ "vecadd", "stream", params, "GB/s", 4.0 * STREAM_N * sizeof(int) * 1e-9,
+                     benchRun([&] { return stream.run(A.data(), B.data(), C.data(), D.data(), STREAM_N); }, reps) });
+        check(D[STREAM_N - 1] == 6 * (STREAM_N - 1) && D[0] == 0, "stream " + params);
+    }
+}
+
+
+
+// ------ OpenMP sum (openMPmulTh.c) ------
+static void benchOmpSum(BenchReport& report, int reps) {
+    const long long expect = (long long)OMP_SUM_N * (OMP_SUM_N - 1) / 2;
+    const double gadds = OMP_SUM_N * 1e-9;
+    std::string params = "n=" + std::to_string(OMP_SUM_N);
+    volatile long long sink; // keeps the loops from being folded
+
+    long long seq = 0;
+    report.add({ "omp", "sequential", params, "Gadds/s", gadds, benchRun([&] { return wallTime([&] {
+        seq = 0;
+        for (int i = 0; i < OMP_SUM_N; i++)
+            seq += i;
+        sink = seq;
+    }); }, reps) });
+    check(seq == expect, "sequential sum");
+
+    for (int t : threadCounts()) {
+        omp_set_num_threads(t);
+        std::string p = params + ";threads=" + std::to_string(t);
+        long long para = 0;
+        report.add({ "omp", "reduction", p, "Gadds/s", gadds, benchRun([&] { return wallTime([&] {
+            para = 0;
+            #pragma omp parallel for reduction(+: para)
+            for (int i = 0; i < OMP_SUM_N; i++)
+                para += i;
+            sink = para;
+        }); }, reps) });
+        check(para == expect, "reduction " + p);
+
+        report.add({ "omp", "ordered", p, "Gadds/s", gadds, benchRun([&] { return wallTime([&] {
+            para = 0;
+            #pragma omp parallel for reduction(+: para) ordered
+            for (int i = 0; i < OMP_SUM_N; i++) {
+                #pragma omp ordered
+                para += i;
+            }
+            sink = para;
+        }); }, reps) });
+        check(para == expect, "ordered " + p);
+    }
+    omp_set_num_threads(threadCounts().back());
+    (void)sink;
+}
+
+
+
+int main(int argc, char** argv) {
+    std::string suite = argc > 1 ? argv[1] : "all";
+    std::string outPath = argc > 2 ? argv[2] : "bench.csv";
+    int reps = argc > 3 ? atoi(argv[3]) : BENCH_REPS;
+    std::string imgPath = argc > 4 ? argv[4] : "genesis.jpg";
+
+    ClRuntime& rt = ClRuntime::get();
+    std::string device = rt.device().getInfo<CL_DEVICE_NAME>();
+    std::cout << "Using device: " << device << ", host threads: " << omp_get_max_threads()
+              << ", " << BENCH_WARMUP << " warm-up + " << reps << " reps per row" << std::endl;
+
+    BenchReport report;
+    if (suite == "all" || suite == "lcs")
+        benchLcs(report, rt, reps);
+    if (suite == "all" || suite == "zernike")
+        benchZernike(report, rt, reps, imgPath);
+    if (suite == "all" || suite == "vecadd")
+        benchVecAdd(report, rt, reps);
+    if (suite == "all" || suite == "omp")
+        benchOmpSum(report, reps);
+    report.write(outPath, device);
+
+    int regressions = 0;
+    if (const char* baseline = getenv("BENCH_BASELINE"))
+        regressions = report.compare(baseline);
+    if (failures)
+        std::cerr << failures << " result mismatch(es)" << std::endl;
+    return failures || regressions ? 1 : 0;
+}
@@ -0,0 +1,357 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+#include <type_traits>
+#include "clRuntime.hpp"
+
+/*
+    Fused elementwise expressions
+    D = A + B * C - 2 * E builds an expression type, not temporaries; assigning it to a ClArray runs
+    1 kernel that reads A, B, C, E once and writes D once: no intermediate buffers.
+    The kernel source is a function of the expression type & vector width only (array & scalar values are
+    kernel args), so it is generated, built & kept once per (expression type, width): later assignments
+    of the same shape only set args & enqueue.
+
+    Types: int, float (all operands of 1 expression share it). Ops: + - * / unary -, vmin, vmax.
+    Width W = 1, 2, 4, 8, 16: vloadW / vstoreW per work-item, scalar tail. Default: the device's preferred
+    vector width, CL_EXPR_WIDTH overrides.
+    Host fallback: evalHost(), or every assignment with CL_EXPR=host: 1 OpenMP `parallel for simd` loop
+    over the same expression (build with -fopenmp -O2 for the SIMD part).
+
+    ClArray keeps a host copy & a pooled device buffer and moves data only when the other side is stale.
+*/
+
+template <typename T> struct ClTypeName;
+template <> struct ClTypeName<int> { static const char* get() { return "int"; } };
+template <> struct ClTypeName<float> { static const char* get() { return "float"; } };
+
+// ------ Expression nodes ------
+// Every node: value_type, decl() (kernel params), code() (OpenCL expression), bind() (kernel args),
+// prepare() (data on the evaluating side), sized() (operand lengths), at() (host value).
+// decl / code / bind walk the tree in the same order, so arg k is the k-th leaf
+template <typename E>
+struct ClExpr {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+
+template <typename T> class ClArray;
+
+// Arrays are held by reference, inner nodes & scalars by value
+template <typename E> struct ClExprRef { typedef E type; };
+template <typename T> struct ClExprRef<ClArray<T>> { typedef const ClArray<T>& type; };
+
+template <typename T>
+struct ClScalar : ClExpr<ClScalar<T>> {
+    typedef T value_type;
+    T v;
+    explicit ClScalar(T v) : v(v) {}
+
+    static void decl(std::string& params, int& arg) {
+        params += "const " + std::string(ClTypeName<T>::get()) + " s" + std::to_string(arg++) + ", ";
+    }
+    // Broadcast at w > 1: operators would widen a scalar, but min / max have no (scalar, vector) overload
+    static std::string code(int& arg, int w, const char*) {
+        std::string s = "s" + std::to_string(arg++);
+        return w > 1 ? "(" + std::string(ClTypeName<T>::get()) + std::to_string(w) + ")(" + s + ")" : s;
+    }
+    void bind(cl::Kernel& k, int& arg) const { k.setArg(arg++, v); }
+    void prepare(bool) const {}
+    bool sized(size_t) const { return true; }
+    T at(size_t) const { return v; }
+};
+
+#define CL_EXPR_OP(Name, sym, hostExpr)                                                          \
+    struct Name {                                                                                \
+        static std::string code(const std::string& l, const std::string& r) { return sym; }     \
+        template <typename T> static T host(T l, T r) { return hostExpr; }                       \
+    };
+CL_EXPR_OP(ClOpAdd, "(" + l + " + " + r + ")", l + r)
+CL_EXPR_OP(ClOpSub, "(" + l + " - " + r + ")", l - r)
+CL_EXPR_OP(ClOpMul, "(" + l + " * " + r + ")", l * r)
+CL_EXPR_OP(ClOpDiv, "(" + l + " / " + r + ")", l / r)
+CL_EXPR_OP(ClOpMin, "min(" + l + ", " + r + ")", std::min(l, r))
+CL_EXPR_OP(ClOpMax, "max(" + l + ", " + r + ")", std::max(l, r))
+#undef CL_EXPR_OP
+
+template <typename Op, typename L, typename R>
+struct ClBinary : ClExpr<ClBinary<Op, L, R>> {
+    typedef typename L::value_type value_type;
+    static_assert(std::is_same<value_type, typename R::value_type>::value, "operands of 1 expression share 1 type");
+    typename ClExprRef<L>::type l;
+    typename ClExprRef<R>::type r;
+    ClBinary(const L& l, const R& r) : l(l), r(r) {}
+
+    static void decl(std::string& params, int& arg) {
+        L::decl(params, arg);
+        R::decl(params, arg);
+    }
+    static std::string code(int& arg, int w, const char* idx) {
+        std::string lc = L::code(arg, w, idx);
+        return Op::code(lc, R::code(arg, w, idx));
+    }
+    void bind(cl::Kernel& k, int& arg) const {
+        l.bind(k, arg);
+        r.bind(k, arg);
+    }
+    void prepare(bool device) const {
+        l.prepare(device);
+        r.prepare(device);
+    }
+    bool sized(size_t n) const { return l.sized(n) && r.sized(n); }
+    value_type at(size_t i) const { return Op::host(l.at(i), r.at(i)); }
+};
+
+template <typename E>
+struct ClNeg : ClExpr<ClNeg<E>> {
+    typedef typename E::value_type value_type;
+    typename ClExprRef<E>::type e;
+    explicit ClNeg(const E& e) : e(e) {}
+
+    static void decl(std::string& params, int& arg) { E::decl(params, arg); }
+    static std::string code(int& arg, int w, const char* idx) { return "(-" + E::code(arg, w, idx) + ")"; }
+    void bind(cl::Kernel& k, int& arg) const { e.bind(k, arg); }
+    void prepare(bool device) const { e.prepare(device); }
+    bool sized(size_t n) const { return e.sized(n); }
+    value_type at(size_t i) const { return -e.at(i); }
+};
+
+
+
+// ------ Array: host copy + device buffer ------
+template <typename T>
+class ClArray : public ClExpr<ClArray<T>> {
+public:
+    typedef T value_type;
+
+    explicit ClArray(size_t n, ClRuntime& rt = ClRuntime::get())
+        : rt_(&rt), host_(n) {}
+    explicit ClArray(const std::vector<T>& v, ClRuntime& rt = ClRuntime::get())
+        : rt_(&rt), host_(v) {}
+    ClArray(ClArray&&) = default;
+
+    // Elementwise copy, like any other expression
+    ClArray& operator=(const ClArray& o) { return *this = static_cast<const ClExpr<ClArray>&>(o); }
+    template <typename E>
+    ClArray& operator=(const ClExpr<E>& e);
+
+    size_t size() const { return host_.size(); }
+
+    // Host view, current. Non-const: the caller may write, so the device copy goes stale
+    const T* data() const {
+        toHost();
+        return host_.data();
+    }
+    T* data() {
+        toHost();
+        devValid_ = false;
+        return host_.data();
+    }
+    T operator[](size_t i) const { return data()[i]; }
+    std::vector<T> vec() const { return std::vector<T>(data(), data() + size()); }
+
+    // Device buffer, current
+    const cl::Buffer& buffer() const {
+        toDevice();
+        return *dev_;
+    }
+
+    void toDevice() const {
+        if (devValid_)
+            return;
+        alloc();
+        if (size())
+            rt_->queue().enqueueWriteBuffer(*dev_, CL_TRUE, 0, size() * sizeof(T), host_.data());
+        devValid_ = true;
+    }
+    void toHost() const {
+        if (hostValid_)
+            return;
+        rt_->queue().enqueueReadBuffer(*dev_, CL_TRUE, 0, size() * sizeof(T), host_.data());
+        hostValid_ = true;
+    }
+
+    // Result written on 1 side: the other goes stale
+    void written(bool device) {
+        if (device)
+            alloc();
+        hostValid_ = !device;
+        devValid_ = device;
+    }
+
+    ClRuntime& runtime() const { return *rt_; }
+
+    // ------ Leaf node ------
+    static void decl(std::string& params, int& arg) {
+        params += "__global const " + std::string(ClTypeName<T>::get()) + "* a" + std::to_string(arg++) + ", ";
+    }
+    static std::string code(int& arg, int w, const char* idx) {
+        std::string a = "a" + std::to_string(arg++);
+        return w > 1 ? "vload" + std::to_string(w) + "(" + idx + ", " + a + ")" : a + "[" + idx + "]";
+    }
+    void bind(cl::Kernel& k, int& arg) const { k.setArg(arg++, buffer()); }
+    void prepare(bool device) const {
+        if (device)
+            toDevice();
+        else
+            toHost();
+    }
+    bool sized(size_t n) const { return size() == n; }
+    T at(size_t i) const { return host_[i]; }
+
+private:
+    void alloc() const {
+        if (dev_.capacity() < std::max<size_t>(1, size() * sizeof(T)))
+            dev_ = rt_->pool().acquire(size() * sizeof(T));
+    }
+
+    ClRuntime* rt_;
+    mutable std::vector<T> host_;
+    mutable PooledBuffer dev_;
+    mutable bool hostValid_ = true, devValid_ = false;
+};
+
+
+
+// ------ Operators ------
+// Scalars take the expression's type: 2 * E is int or float as E is
+#define CL_EXPR_BINARY(fn, Op)                                                                   \
+    template <typename L, typename R>                                                            \
+    ClBinary<Op, L, R> fn(const ClExpr<L>& l, const ClExpr<R>& r) {                              \
+        return ClBinary<Op, L, R>(l.self(), r.self());                                           \
+    }                                                                                            \
+    template <typename L>                                                                        \
+    ClBinary<Op, L, ClScalar<typename L::value_type>> fn(const ClExpr<L>& l, typename L::value_type s) { \
+        return ClBinary<Op, L, ClScalar<typename L::value_type>>(l.self(), ClScalar<typename L::value_type>(s)); \
+    }                                                                                            \
+    template <typename R>                                                                        \
+    ClBinary<Op, ClScalar<typename R::value_type>, R> fn(typename R::value_type s, const ClExpr<R>& r) { \
+        return ClBinary<Op, ClScalar<typename R::value_type>, R>(ClScalar<typename R::value_type>(s), r.self()); \
+    }
+CL_EXPR_BINARY(operator+, ClOpAdd)
+CL_EXPR_BINARY(operator-, ClOpSub)
+CL_EXPR_BINARY(operator*, ClOpMul)
+CL_EXPR_BINARY(operator/, ClOpDiv)
+CL_EXPR_BINARY(vmin, ClOpMin)
+CL_EXPR_BINARY(vmax, ClOpMax)
+#undef CL_EXPR_BINARY
+
+template <typename E>
+ClNeg<E> operator-(const ClExpr<E>& e) { return ClNeg<E>(e.self()); }
+
+
+
+// ------ Evaluation ------
+// Kernel source of expression E at width w
+template <typename E>
+std::string clExprSource(int w) {
+    typedef typename E::value_type T;
+    std::string t = ClTypeName<T>::get();
+    std::string params, src;
+    int arg = 0;
+    E::decl(params, arg);
+    int argVec = 0, argTail = 0;
+    std::string vec = E::code(argVec, w, "i");
+    std::string tail = E::code(argTail, 1, "j");
+
+    src = "__kernel void fused(" + params + "__global " + t + "* out, const ulong n) {\n"
+          "    size_t i = get_global_id(0);\n";
+    if (w > 1)
+        src += "    if ((i + 1) * " + std::to_string(w) + " <= n) {\n"
+               "        vstore" + std::to_string(w) + "(" + vec + ", i, out);\n"
+               "        return;\n"
+               "    }\n"
+               "    for (size_t j = i * " + std::to_string(w) + "; j < n; j++)\n"
+               "        out[j] = " + tail + ";\n";
+    else
+        src += "    size_t j = i;\n"
+               "    if (j < n)\n"
+               "        out[j] = " + tail + ";\n";
+    return src + "}\n";
+}
+
+// Vector width: CL_EXPR_WIDTH, else the device's preferred width for T, as 1, 2, 4, 8 or 16
+template <typename T>
+int clExprWidth(const cl::Device& dev) {
+    int w;
+    if (const char* env = getenv("CL_EXPR_WIDTH"))
+        w = atoi(env);
+    else
+        w = std::is_same<T, float>::value ? dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT>()
+                                          : dev.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT>();
+    int p = 1;
+    while (p * 2 <= std::min(w, 16))
+        p *= 2;
+    return p;
+}
+
+// 1 kernel per (expression type, width), built on first use. Not thread-safe: args live in the shared kernel
+template <typename E>
+cl::Kernel& clExprKernel(ClRuntime& rt, int w) {
+    static std::map<int, cl::Kernel> byWidth;
+    auto it = byWidth.find(w);
+    if (it == byWidth.end())
+        it = byWidth.emplace(w, cl::Kernel(rt.program(clExprSource<E>(w).c_str()), "fused")).first;
+    return it->second;
+}
+
+template <typename T, typename E>
+void clExprCheck(const ClArray<T>& out, const ClExpr<E>& e) {
+    static_assert(std::is_same<T, typename E::value_type>::value, "result & expression types differ");
+    if (!e.self().sized(out.size())) {
+        std::cerr << "Error: expression operands differ in length from the result (" << out.size() << ")." << std::endl;
+        exit(1);
+    }
+}
+
+// Device: 1 fused kernel on the runtime's queue 0. Returns its event (profiling times)
+template <typename T, typename E>
+cl::Event clEval(ClArray<T>& out, const ClExpr<E>& e, int w = 0) {
+    clExprCheck(out, e);
+    ClRuntime& rt = out.runtime();
+    if (w <= 0)
+        w = clExprWidth<T>(rt.device());
+    cl::Kernel& kern = clExprKernel<E>(rt, w);
+
+    e.self().prepare(true);
+    out.written(true);
+    int arg = 0;
+    e.self().bind(kern, arg);
+    kern.setArg(arg++, out.buffer()); // current: written() above, no upload
+    kern.setArg(arg++, (cl_ulong)out.size());
+
+    cl::Event ev;
+    size_t items = (out.size() + w - 1) / w;
+    if (items)
+        rt.queue().enqueueNDRangeKernel(kern, cl::NullRange, cl::NDRange(items), cl::NullRange, nullptr, &ev);
+    return ev;
+}
+
+// Host: the same expression, 1 SIMD loop over all threads
+template <typename T, typename E>
+void evalHost(ClArray<T>& out, const ClExpr<E>& e) {
+    clExprCheck(out, e);
+    const E& x = e.self();
+    x.prepare(false);
+    T* o = out.data();
+    long n = out.size();
+    #pragma omp parallel for simd
+    for (long i = 0; i < n; i++)
+        o[i] = x.at(i);
+    out.written(false);
+}
+
+template <typename T>
+template <typename E>
+ClArray<T>& ClArray<T>::operator=(const ClExpr<E>& e) {
+    const char* env = getenv("CL_EXPR");
+    if (env && std::string(env) == "host")
+        evalHost(*this, e);
+    else
+        clEval(*this, e);
+    return *this;
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+    On-disk cache of built OpenCL programs
+    Key = hash of (kernel source, build options, platform name & version, device name & version, driver version),
+    so a new driver or kernel edit is a miss, never a stale hit.
+    Entry <CL_CACHE_DIR>/<key>.clbin: magic, key string, payload size, payload checksum, device binary.
+    Any mismatch or a failed clCreateProgramWithBinary / clBuildProgram deletes the entry and rebuilds from source.
+    Written to a temp file then renamed: concurrent runs never see half an entry.
+
+    CL_CACHE_DIR: cache directory (default .clcache), CL_CACHE=0: always build from source
+*/
+
+#define CL_CACHE_MAGIC "CLBIN001"
+
+struct ClCacheStat {
+    bool hit = false;
+    double ms = 0; // create + build
+};
+
+// FNV-1a, 64 bit
+inline uint64_t clCacheHash(const void* p, size_t len, uint64_t h = 1469598103934665603ULL) {
+    const unsigned char* s = (const unsigned char*)p;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ s[i]) * 1099511628211ULL;
+    return h;
+}
+
+inline std::string clCacheKey(cl_device_id dev, const char* src, const std::string& opts) {
+    auto info = [](auto get, auto obj, cl_uint param) {
+        size_t len = 0;
+        get(obj, param, 0, nullptr, &len);
+        std::string s(len, '\0');
+        get(obj, param, len, &s[0], nullptr);
+        return s;
+    };
+    cl_platform_id plat;
+    clGetDeviceInfo(dev, CL_DEVICE_PLATFORM, sizeof(plat), &plat, nullptr);
+    std::ostringstream key;
+    key << info(clGetPlatformInfo, plat, CL_PLATFORM_NAME) << '|' << info(clGetPlatformInfo, plat, CL_PLATFORM_VERSION) << '|'
+        << info(clGetDeviceInfo, dev, CL_DEVICE_NAME) << '|' << info(clGetDeviceInfo, dev, CL_DEVICE_VERSION) << '|'
+        << info(clGetDeviceInfo, dev, CL_DRIVER_VERSION) << '|' << opts << '|';
+    std::string k = key.str();
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)clCacheHash(src, strlen(src), clCacheHash(k.data(), k.size())));
+    return k + hex;
+}
+
+inline std::string clCachePath(const std::string& key) {
+    const char* dir = getenv("CL_CACHE_DIR");
+    std::string d = dir ? dir : ".clcache";
+    mkdir(d.c_str(), 0755);
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)clCacheHash(key.data(), key.size()));
+    return d + "/" + hex + ".clbin";
+}
+
+// Valid entry -> binary, else empty
+inline std::vector<unsigned char> clCacheLoad(const std::string& path, const std::string& key) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    uint64_t keyLen, size, sum;
+    if (!in.read(magic, 8) || std::string(magic, 8) != CL_CACHE_MAGIC || !in.read((char*)&keyLen, 8) || keyLen != key.size())
+        return {};
+    std::string k(keyLen, '\0');
+    if (!in.read(&k[0], keyLen) || k != key || !in.read((char*)&size, 8) || !in.read((char*)&sum, 8) || size > (1ULL << 30))
+        return {};
+    std::vector<unsigned char> bin(size);
+    if (!in.read((char*)bin.data(), size) || in.peek() != EOF || clCacheHash(bin.data(), size) != sum)
+        return {};
+    return bin;
+}
+
+inline void clCacheStore(const std::string& path, const std::string& key, const std::vector<unsigned char>& bin) {
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        uint64_t keyLen = key.size(), size = bin.size(), sum = clCacheHash(bin.data(), bin.size());
+        out.write(CL_CACHE_MAGIC, 8);
+        out.write((const char*)&keyLen, 8);
+        out.write(key.data(), keyLen);
+        out.write((const char*)&size, 8);
+        out.write((const char*)&sum, 8);
+        out.write((const char*)bin.data(), size);
+        if (!out)
+            return void(std::remove(tmp.c_str()));
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
+
+// Built program for 1 device: from the cache when possible, else from source (then cached).
+// Build errors print the log and exit, like the samples do
+inline cl_program clBuildCached(cl_context ctx, cl_device_id dev, const char* src, const std::string& opts = "",
+                                ClCacheStat* stat = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    const char* env = getenv("CL_CACHE");
+    bool enabled = !env || std::string(env) != "0";
+    std::string key = clCacheKey(dev, src, opts);
+    std::string path = clCachePath(key);
+    cl_program prog = nullptr;
+    cl_int err;
+
+    std::vector<unsigned char> bin = enabled ? clCacheLoad(path, key) : std::vector<unsigned char>();
+    if (!bin.empty()) {
+        const unsigned char* p = bin.data();
+        size_t len = bin.size();
+        cl_int status;
+        prog = clCreateProgramWithBinary(ctx, 1, &dev, &len, &p, &status, &err);
+        if (err != CL_SUCCESS || status != CL_SUCCESS || clBuildProgram(prog, 1, &dev, opts.c_str(), nullptr, nullptr) != CL_SUCCESS) {
+            if (prog)
+                clReleaseProgram(prog);
+            prog = nullptr;
+            std::remove(path.c_str()); // corrupt / rejected by the driver
+        }
+    }
+    bool hit = prog != nullptr;
+
+    if (!prog) {
+        size_t len = strlen(src);
+        prog = clCreateProgramWithSource(ctx, 1, &src, &len, &err);
+        if (clBuildProgram(prog, 1, &dev, opts.c_str(), nullptr, nullptr) != CL_SUCCESS) {
+            size_t logLen;
+            clGetProgramBuildInfo(prog, dev, CL_PROGRAM_BUILD_LOG, 0, nullptr, &logLen);
+            std::string log(logLen, '\0');
+            clGetProgramBuildInfo(prog, dev, CL_PROGRAM_BUILD_LOG, logLen, &log[0], nullptr);
+            std::cout << " Error building: " << log << std::endl;
+            exit(1);
+        }
+        size_t size;
+        if (enabled && clGetProgramInfo(prog, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, nullptr) == CL_SUCCESS && size > 0) {
+            std::vector<unsigned char> out(size);
+            unsigned char* p = out.data();
+            if (clGetProgramInfo(prog, CL_PROGRAM_BINARIES, sizeof(p), &p, nullptr) == CL_SUCCESS)
+                clCacheStore(path, key, out);
+        }
+    }
+
+    if (stat) {
+        stat->hit = hit;
+        stat->ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return prog;
+}
+
+// C++ bindings: the cl::Program owns the handle
+inline cl::Program buildCached(const cl::Context& contxt, const cl::Device& dev, const char* src, const std::string& opts = "",
+                               ClCacheStat* stat = nullptr) {
+    return cl::Program(clBuildCached(contxt(), dev(), src, opts, stat));
+}
+
+inline void printCacheStat(const ClCacheStat& stat) {
+    std::cout << "Program build: " << stat.ms << " ms (" << (stat.hit ? "warm, cached binary" : "cold, from source") << ")\n";
+}
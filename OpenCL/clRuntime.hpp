@@ -0,0 +1,370 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include "clProgramCache.hpp"
+
+/*
+    Shared OpenCL runtime for the samples
+    ClRuntime::get(): 1 process-wide device, context, queue set, program memo & buffer pool.
+    Device chosen by policy (type, min. compute units / memory) across every platform, not all_devices[0].
+    CL_DEVICE=gpu|cpu|accel|<name substring> overrides the policy's type.
+
+    Multi-device engines: deviceSet() = every usable device, CPU devices split into NUMA sub-devices,
+    each wrapped in a ClDevice (own context, queue & program memo).
+
+    BufferPool: device buffers in power-of-2 size classes (>= CL_POOL_MIN_BYTES), recycled per (class, flags).
+    Above CL_POOL_LARGE_BYTES the classes step by CL_POOL_LARGE_STEP instead, and no class exceeds the
+    device's CL_DEVICE_MAX_MEM_ALLOC_SIZE: a request sized from the device limits stays allocatable.
+    acquire() returns a PooledBuffer that goes back to its free list when destroyed,
+    so repeated LCS / Zernike runs in 1 process reuse the same allocations.
+    Release a PooledBuffer only once the commands using it are done (or queued on the same in-order queue).
+*/
+
+#define CL_POOL_MIN_BYTES 4096
+#define CL_POOL_LARGE_BYTES (64ull << 20)
+#define CL_POOL_LARGE_STEP (16ull << 20)
+
+struct DevicePolicy {
+    cl_device_type type = CL_DEVICE_TYPE_ALL; // preferred; others only when none match
+    cl_uint minComputeUnits = 0;
+    cl_ulong minGlobalMem = 0;
+};
+
+inline void printDeviceInfo(const cl::Device& device) {
+    std::cout << "  Device Name: " << device.getInfo<CL_DEVICE_NAME>() << "\n";
+    std::cout << "  Device Type: ";
+    switch (device.getInfo<CL_DEVICE_TYPE>()) {
+    case CL_DEVICE_TYPE_CPU: std::cout << "CPU"; break;
+    case CL_DEVICE_TYPE_GPU: std::cout << "GPU"; break;
+    case CL_DEVICE_TYPE_ACCELERATOR: std::cout << "Accelerator"; break;
+    default: std::cout << "Other"; break;
+    }
+    std::cout << "\n";
+
+    std::cout << "  Compute Units: " << device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() << "\n";
+    std::cout << "  Global Memory: " << device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / (1024 * 1024) << " MB\n";
+    std::cout << "  Local Memory: " << device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() / 1024 << " KB\n";
+    std::cout << "  Max Work Group Size: " << device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() << "\n";
+    std::cout << "  Max Clock Frequency: " << device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>() << " MHz\n";
+    std::cout << "----------------------------------------\n";
+}
+
+inline std::vector<cl::Device> allDevices() {
+    std::vector<cl::Platform> all_platforms;
+    cl::Platform::get(&all_platforms);
+    std::vector<cl::Device> all;
+    for (const cl::Platform& plat : all_platforms) {
+        std::vector<cl::Device> devs;
+        plat.getDevices(CL_DEVICE_TYPE_ALL, &devs);
+        all.insert(all.end(), devs.begin(), devs.end());
+    }
+    return all;
+}
+
+// CL_DEVICE=gpu|cpu|accel overrides policy.type, anything else is a name substring (returned)
+inline std::string applyDeviceEnv(DevicePolicy& policy) {
+    std::string name;
+    if (const char* env = getenv("CL_DEVICE")) {
+        std::string e = env;
+        if (e == "gpu") policy.type = CL_DEVICE_TYPE_GPU;
+        else if (e == "cpu") policy.type = CL_DEVICE_TYPE_CPU;
+        else if (e == "accel") policy.type = CL_DEVICE_TYPE_ACCELERATOR;
+        else name = e;
+    }
+    return name;
+}
+
+// Best device for the policy: preferred type first, then compute units x clock, then memory
+inline cl::Device selectDevice(DevicePolicy policy = {}) {
+    std::string name = applyDeviceEnv(policy);
+
+    std::vector<cl::Device> all_devices = allDevices();
+    cl::Device best;
+    double bestScore = -1;
+    for (const cl::Device& dev : all_devices) {
+        if (dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() < policy.minComputeUnits ||
+            dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() < policy.minGlobalMem)
+            continue;
+        if (!name.empty() && dev.getInfo<CL_DEVICE_NAME>().find(name) == std::string::npos)
+            continue;
+        double score = (double)dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() * dev.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>()
+                     + dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() * 1e-12; // memory breaks ties
+        if (dev.getInfo<CL_DEVICE_TYPE>() & policy.type)
+            score += 1e12;
+        if (score > bestScore) {
+            bestScore = score;
+            best = dev;
+        }
+    }
+    if (bestScore < 0) {
+        std::cout << " No devices found.\n";
+        exit(1);
+    }
+    return best;
+}
+
+
+
+// ------ Buffer pool ------
+class BufferPool;
+
+// Owning handle: back to the pool on destruction, movable, not copyable
+class PooledBuffer {
+public:
+    PooledBuffer() {}
+    PooledBuffer(BufferPool* pool, cl::Buffer buf, size_t cls, cl_mem_flags flags)
+        : pool_(pool), buf_(buf), cls_(cls), flags_(flags) {}
+    PooledBuffer(PooledBuffer&& o) noexcept { *this = std::move(o); }
+    PooledBuffer& operator=(PooledBuffer&& o) noexcept;
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+    ~PooledBuffer() { release(); }
+
+    const cl::Buffer& operator*() const { return buf_; }
+    cl_mem get() const { return buf_(); }
+    size_t capacity() const { return cls_; }
+    void release();
+
+private:
+    BufferPool* pool_ = nullptr;
+    cl::Buffer buf_;
+    size_t cls_ = 0;
+    cl_mem_flags flags_ = 0;
+};
+
+class BufferPool {
+public:
+    explicit BufferPool(const cl::Context& contxt) : contxt_(contxt) {
+        for (const cl::Device& d : contxt_.getInfo<CL_CONTEXT_DEVICES>())
+            maxAlloc_ = std::min<size_t>(maxAlloc_, d.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>());
+    }
+
+    // Size class of a request: power of 2 up to CL_POOL_LARGE_BYTES, then multiples of CL_POOL_LARGE_STEP,
+    // capped at the max allocation (a request above it is passed through and fails in the runtime)
+    size_t sizeClass(size_t bytes) const {
+        size_t cls = CL_POOL_MIN_BYTES;
+        if (bytes > CL_POOL_LARGE_BYTES)
+            cls = (bytes + CL_POOL_LARGE_STEP - 1) / CL_POOL_LARGE_STEP * CL_POOL_LARGE_STEP;
+        while (cls < bytes)
+            cls *= 2;
+        return std::max(bytes, std::min(cls, maxAlloc_));
+    }
+
+    // bytes rounded up to the size class. Host-pointer flags are not poolable
+    PooledBuffer acquire(size_t bytes, cl_mem_flags flags = CL_MEM_READ_WRITE) {
+        size_t cls = sizeClass(bytes);
+        std::lock_guard<std::mutex> lk(mu_);
+        auto& list = free_[{ cls, flags }];
+        if (!list.empty()) {
+            cl::Buffer buf = list.back();
+            list.pop_back();
+            hits_++;
+            return PooledBuffer(this, buf, cls, flags);
+        }
+        allocs_++;
+        return PooledBuffer(this, cl::Buffer(contxt_, flags, cls), cls, flags);
+    }
+
+    void recycle(const cl::Buffer& buf, size_t cls, cl_mem_flags flags) {
+        std::lock_guard<std::mutex> lk(mu_);
+        free_[{ cls, flags }].push_back(buf);
+    }
+
+    // Release every idle buffer
+    void trim() {
+        std::lock_guard<std::mutex> lk(mu_);
+        free_.clear();
+    }
+
+    size_t allocations() const { return allocs_; }
+    size_t reuses() const { return hits_; }
+
+private:
+    cl::Context contxt_;
+    std::map<std::pair<size_t, cl_mem_flags>, std::vector<cl::Buffer>> free_;
+    std::mutex mu_;
+    size_t maxAlloc_ = SIZE_MAX;
+    std::atomic<size_t> allocs_{ 0 }, hits_{ 0 }; // read without mu_
+};
+
+inline PooledBuffer& PooledBuffer::operator=(PooledBuffer&& o) noexcept {
+    if (this != &o) {
+        release();
+        pool_ = o.pool_;
+        buf_ = o.buf_;
+        cls_ = o.cls_;
+        flags_ = o.flags_;
+        o.pool_ = nullptr;
+        o.buf_ = cl::Buffer();
+    }
+    return *this;
+}
+
+inline void PooledBuffer::release() {
+    if (pool_)
+        pool_->recycle(buf_, cls_, flags_);
+    pool_ = nullptr;
+    buf_ = cl::Buffer();
+}
+
+
+
+// ------ Runtime: 1 per process ------
+class ClRuntime {
+public:
+    // First call picks the device, later policies are ignored
+    static ClRuntime& get(const DevicePolicy& policy = {}) {
+        static ClRuntime rt(policy);
+        return rt;
+    }
+
+    const cl::Device& device() const { return dev_; }
+    const cl::Context& context() const { return contxt_; }
+    BufferPool& pool() { return pool_; }
+
+    // In-order queue i (created on first use), profiling enabled
+    cl::CommandQueue& queue(size_t i = 0) {
+        std::lock_guard<std::mutex> lk(mu_);
+        while (queues_.size() <= i)
+            queues_.emplace_back(contxt_, dev_, CL_QUEUE_PROFILING_ENABLE);
+        return queues_[i];
+    }
+
+    // Built once per process (and once per machine via the binary cache)
+    cl::Program program(const char* src, const std::string& opts = "", ClCacheStat* stat = nullptr) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto key = std::make_pair(std::string(src), opts);
+        auto it = programs_.find(key);
+        if (it != programs_.end()) {
+            if (stat)
+                *stat = { true, 0.0 };
+            return it->second;
+        }
+        cl::Program prog = buildCached(contxt_, dev_, src, opts, stat);
+        programs_[key] = prog;
+        return prog;
+    }
+
+private:
+    explicit ClRuntime(const DevicePolicy& policy)
+        : dev_(selectDevice(policy)), contxt_({ dev_ }), pool_(contxt_) {}
+
+    cl::Device dev_;
+    cl::Context contxt_;
+    BufferPool pool_;
+    std::deque<cl::CommandQueue> queues_; // deque: references stay valid as it grows
+    std::map<std::pair<std::string, std::string>, cl::Program> programs_;
+    std::mutex mu_;
+};
+
+
+
+// ------ Multi-device ------
+// CL_SUBDEVICES=numa (default) | <n> | off: a CPU device is split by NUMA domain (or into sub-devices of
+// n compute units each). 1 domain, no partition support or any error: the device stays whole
+inline std::vector<cl::Device> subDevices(cl::Device dev) {
+    const char* env = getenv("CL_SUBDEVICES");
+    std::string mode = env ? env : "numa";
+    if (mode == "off" || !(dev.getInfo<CL_DEVICE_TYPE>() & CL_DEVICE_TYPE_CPU) ||
+        dev.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>() < 2)
+        return { dev };
+    cl_device_partition_property numa[] = { CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0 };
+    cl_device_partition_property equal[] = { CL_DEVICE_PARTITION_EQUALLY, (cl_device_partition_property)atoi(mode.c_str()), 0 };
+    std::vector<cl::Device> subs;
+    if (dev.createSubDevices(mode == "numa" ? numa : equal, &subs) != CL_SUCCESS || subs.size() < 2)
+        return { dev };
+    return subs;
+}
+
+// Every device of the preferred type, or every device when none has it (e.g. policy GPU on a CPU-only box),
+// then split by subDevices(). CL_DEVICE applies as in selectDevice
+inline std::vector<cl::Device> deviceSet(DevicePolicy policy = {}) {
+    std::string name = applyDeviceEnv(policy);
+    std::vector<cl::Device> match, other;
+    for (const cl::Device& dev : allDevices()) {
+        if (dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() < policy.minComputeUnits ||
+            dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() < policy.minGlobalMem)
+            continue;
+        if (!name.empty() && dev.getInfo<CL_DEVICE_NAME>().find(name) == std::string::npos)
+            continue;
+        (dev.getInfo<CL_DEVICE_TYPE>() & policy.type ? match : other).push_back(dev);
+    }
+    if (match.empty() && !other.empty())
+        std::cout << "No device of the preferred type, using all " << other.size() << " others." << std::endl;
+    std::vector<cl::Device> set;
+    for (const cl::Device& dev : match.empty() ? other : match)
+        for (const cl::Device& sub : subDevices(dev))
+            set.push_back(sub);
+    if (set.empty()) {
+        std::cout << " No devices found.\n";
+        exit(1);
+    }
+    return set;
+}
+
+// Relative speed for static splits: compute units x clock
+inline double deviceWeight(const cl::Device& dev) {
+    return (double)dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() * std::max<cl_uint>(1, dev.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>());
+}
+
+// n into parts proportional to the weights, multiples of align (but the last). Returns the k + 1 part starts
+inline std::vector<size_t> splitByWeight(size_t n, const std::vector<double>& weight, size_t align = 1) {
+    double total = 0;
+    for (double w : weight)
+        total += w;
+    std::vector<size_t> start{ 0 };
+    double acc = 0;
+    for (size_t k = 0; k + 1 < weight.size(); k++) {
+        acc += weight[k];
+        size_t s = (size_t)(n * acc / total) / align * align;
+        start.push_back(std::min(n, std::max(s, start.back())));
+    }
+    start.push_back(n);
+    return start;
+}
+
+// 1 device or sub-device with its own context & in-order queue: device() / context() / program() like ClRuntime
+class ClDevice {
+public:
+    explicit ClDevice(const cl::Device& dev)
+        : dev_(dev), contxt_({ dev }), queue_(contxt_, dev_, CL_QUEUE_PROFILING_ENABLE) {}
+
+    const cl::Device& device() const { return dev_; }
+    const cl::Context& context() const { return contxt_; }
+    cl::CommandQueue& queue() { return queue_; }
+    std::string name() const { return dev_.getInfo<CL_DEVICE_NAME>(); }
+    double weight() const { return deviceWeight(dev_); }
+
+    cl::Program program(const char* src, const std::string& opts = "", ClCacheStat* stat = nullptr) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto key = std::make_pair(std::string(src), opts);
+        auto it = programs_.find(key);
+        if (it != programs_.end())
+            return it->second;
+        return programs_[key] = buildCached(contxt_, dev_, src, opts, stat);
+    }
+
+private:
+    cl::Device dev_;
+    cl::Context contxt_;
+    cl::CommandQueue queue_;
+    std::map<std::pair<std::string, std::string>, cl::Program> programs_;
+    std::mutex mu_;
+};
+
+// Buffer of at least bytes, regrown by doubling
+inline void reserveBuffer(const cl::Context& contxt, cl::Buffer& buf, size_t& cap, size_t bytes, cl_mem_flags flags) {
+    if (bytes <= cap)
+        return;
+    cap = std::max(bytes, 2 * cap);
+    buf = cl::Buffer(contxt, flags, cap);
+}
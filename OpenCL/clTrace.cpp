@@ -0,0 +1,348 @@
+#include <CL/cl.h>
+#include <dlfcn.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <algorithm>
+
+/*
+    Enqueue tracer: queued / submit / start / end of every write, read, fill, copy, map & kernel
+    No code change in the samples, either
+        LD_PRELOAD:  g++ -O2 -shared -fPIC clTrace.cpp -o libcltrace.so -ldl
+                     CL_TRACE=trace.json LD_PRELOAD=./libcltrace.so ./zernikeEdgeDetect
+        or linked:   g++ LCSpara.cpp clTrace.cpp -lOpenCL -ldl   (inert unless CL_TRACE is set)
+    The clEnqueue* / clCreateCommandQueue* symbols below shadow the ICD loader's and forward to it (dlsym RTLD_NEXT).
+    With CL_TRACE set, queues get CL_QUEUE_PROFILING_ENABLE and every command gets an event we retain.
+
+    CL_TRACE=<file.json> (or 1: cltrace.json): Chrome trace (chrome://tracing, ui.perfetto.dev), 1 row per queue
+    Summary on stderr at exit: per command name, count, device time, GB/s for transfers,
+    queue delay (queued -> start), and for kernels the work-group fill of the compute units.
+*/
+
+#define TRACE_RESOLVE_EVERY 1024 // completed events resolved (and released) every N records
+
+struct TraceRec {
+    cl_event ev;
+    std::string name;
+    int queue;
+    size_t bytes;      // transfers
+    size_t groups;     // kernels: #work-groups (0: local size left to the runtime)
+    size_t wgSize;
+    cl_ulong localMem; // kernels: __local bytes per work-group
+    cl_ulong t[4];     // queued, submit, start, end (ns)
+};
+
+struct DeviceLimits {
+    cl_uint cus;
+    cl_ulong localMem;
+};
+
+static std::mutex traceMu;
+static std::vector<TraceRec> pending, done;
+static std::map<cl_command_queue, int> queueIds;
+static std::vector<DeviceLimits> queueDevs; // by queue id
+
+static const char* tracePath() {
+    static const char* path = [] {
+        const char* env = getenv("CL_TRACE");
+        if (!env || !*env || std::string(env) == "0")
+            return (const char*)nullptr;
+        return std::string(env) == "1" ? "cltrace.json" : env;
+    }();
+    return path;
+}
+
+// Next definition of the symbol: the ICD loader / driver
+template <typename F>
+static F real(const char* name) {
+    F f = (F)dlsym(RTLD_NEXT, name);
+    if (!f) {
+        fprintf(stderr, "clTrace: cannot resolve %s\n", name);
+        exit(1);
+    }
+    return f;
+}
+#define REAL(fn) static auto real_##fn = real<decltype(&fn)>(#fn)
+
+static bool resolve(TraceRec& r) {
+    cl_int status;
+    clGetEventInfo(r.ev, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, nullptr);
+    if (status > CL_COMPLETE) // queued / submitted / running
+        return false;
+    const cl_profiling_info info[4] = { CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT,
+                                        CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END };
+    for (int k = 0; k < 4; k++)
+        if (status < 0 || clGetEventProfilingInfo(r.ev, info[k], sizeof(cl_ulong), &r.t[k], nullptr) != CL_SUCCESS)
+            r.t[k] = 0; // failed command or queue without profiling
+    clReleaseEvent(r.ev);
+    return true;
+}
+
+static void resolvePending(bool wait) {
+    std::vector<TraceRec> still;
+    for (TraceRec& r : pending) {
+        if (wait)
+            clWaitForEvents(1, &r.ev);
+        if (resolve(r))
+            done.push_back(r);
+        else
+            still.push_back(r);
+    }
+    pending.swap(still);
+}
+
+static void writeTrace() {
+    std::lock_guard<std::mutex> lk(traceMu);
+    resolvePending(true);
+    if (done.empty())
+        return;
+
+    cl_ulong t0 = ~0ULL;
+    for (const TraceRec& r : done)
+        if (r.t[0])
+            t0 = std::min(t0, r.t[0]);
+
+    FILE* f = fopen(tracePath(), "w");
+    if (!f) {
+        fprintf(stderr, "clTrace: cannot write %s\n", tracePath());
+        return;
+    }
+    fprintf(f, "{\"traceEvents\":[\n");
+    for (auto& q : queueIds)
+        fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"queue %d\"}},\n", q.second, q.second);
+    bool first = true;
+    for (const TraceRec& r : done) {
+        if (!r.t[2] || !r.t[3])
+            continue;
+        double dur = (r.t[3] - r.t[2]) * 1e-3; // us
+        fprintf(f, "%s{\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f,\"args\":{"
+                   "\"queued_us\":%.3f,\"submit_us\":%.3f,\"bytes\":%zu",
+                first ? "" : ",\n", r.queue, r.name.c_str(), (r.t[2] - t0) * 1e-3, dur,
+                (r.t[0] - t0) * 1e-3, (r.t[1] - t0) * 1e-3, r.bytes);
+        if (r.bytes && dur > 0)
+            fprintf(f, ",\"GB/s\":%.3f", r.bytes / (dur * 1e3));
+        if (r.groups)
+            fprintf(f, ",\"work_groups\":%zu,\"wg_size\":%zu,\"local_mem\":%llu", r.groups, r.wgSize, (unsigned long long)r.localMem);
+        fprintf(f, "}}");
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    // ------ Summary ------
+    struct Agg { size_t n = 0; double ns = 0, delay = 0, bytes = 0, fill = 0; size_t fillN = 0; };
+    std::map<std::string, Agg> agg;
+    for (const TraceRec& r : done) {
+        if (!r.t[2] || !r.t[3])
+            continue;
+        Agg& a = agg[r.name];
+        a.n++;
+        a.ns += r.t[3] - r.t[2];
+        a.delay += r.t[2] - r.t[0];
+        a.bytes += r.bytes;
+        if (r.groups) {
+            // fill of the last wave: groups / (waves x slots), slots = CUs x groups per CU allowed by __local use
+            const DeviceLimits& d = queueDevs[r.queue];
+            size_t perCu = r.localMem ? std::max<size_t>(1, d.localMem / r.localMem) : 1;
+            size_t slots = (size_t)d.cus * perCu;
+            size_t waves = (r.groups + slots - 1) / slots;
+            a.fill += (double)r.groups / (waves * slots);
+            a.fillN++;
+        }
+    }
+    fprintf(stderr, "\n%-28s %8s %12s %12s %10s %12s\n", "command", "count", "device ms", "delay ms", "GB/s", "CU fill");
+    for (auto& [name, a] : agg) {
+        fprintf(stderr, "%-28s %8zu %12.3f %12.3f", name.c_str(), a.n, a.ns * 1e-6, a.delay * 1e-6 / a.n);
+        if (a.bytes > 0)
+            fprintf(stderr, " %10.2f", a.bytes / a.ns);
+        else
+            fprintf(stderr, " %10s", "-");
+        if (a.fillN)
+            fprintf(stderr, " %11.0f%%", 100.0 * a.fill / a.fillN);
+        fprintf(stderr, "\n");
+    }
+    fprintf(stderr, "Trace written to %s (%zu commands)\n", tracePath(), done.size());
+}
+
+static int queueId(cl_command_queue q) {
+    auto it = queueIds.find(q);
+    if (it != queueIds.end())
+        return it->second;
+    cl_device_id dev;
+    DeviceLimits d = { 1, 0 };
+    if (clGetCommandQueueInfo(q, CL_QUEUE_DEVICE, sizeof(dev), &dev, nullptr) == CL_SUCCESS) {
+        clGetDeviceInfo(dev, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(d.cus), &d.cus, nullptr);
+        clGetDeviceInfo(dev, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(d.localMem), &d.localMem, nullptr);
+    }
+    queueDevs.push_back(d);
+    int id = queueIds.size();
+    queueIds[q] = id;
+    return id;
+}
+
+// Called after the real enqueue: takes over our event, or retains the caller's
+static void record(cl_int err, cl_command_queue q, cl_event* userEv, cl_event ownEv, const char* name,
+                   size_t bytes, size_t groups = 0, size_t wgSize = 0, cl_ulong localMem = 0) {
+    if (err != CL_SUCCESS)
+        return;
+    cl_event ev = ownEv;
+    if (userEv) {
+        ev = *userEv;
+        clRetainEvent(ev);
+    }
+    std::lock_guard<std::mutex> lk(traceMu);
+    static bool registered = (atexit(writeTrace), true);
+    (void)registered;
+    pending.push_back({ ev, name, queueId(q), bytes, groups, wgSize, localMem, { 0, 0, 0, 0 } });
+    if (pending.size() % TRACE_RESOLVE_EVERY == 0)
+        resolvePending(false);
+}
+
+// Event out-param for the real call: the caller's, else ours
+#define TRACE_EVENT cl_event own = nullptr; cl_event* evOut = tracePath() ? (event ? event : &own) : event
+
+
+
+extern "C" {
+
+cl_command_queue clCreateCommandQueue(cl_context context, cl_device_id device, cl_command_queue_properties props, cl_int* err) {
+    REAL(clCreateCommandQueue);
+    if (tracePath())
+        props |= CL_QUEUE_PROFILING_ENABLE;
+    return real_clCreateCommandQueue(context, device, props, err);
+}
+
+cl_command_queue clCreateCommandQueueWithProperties(cl_context context, cl_device_id device, const cl_queue_properties* props, cl_int* err) {
+    REAL(clCreateCommandQueueWithProperties);
+    if (!tracePath())
+        return real_clCreateCommandQueueWithProperties(context, device, props, err);
+    std::vector<cl_queue_properties> p;
+    bool found = false;
+    for (size_t i = 0; props && props[i]; i += 2) {
+        p.push_back(props[i]);
+        p.push_back(props[i] == CL_QUEUE_PROPERTIES ? props[i + 1] | CL_QUEUE_PROFILING_ENABLE : props[i + 1]);
+        found |= props[i] == CL_QUEUE_PROPERTIES;
+    }
+    if (!found) {
+        p.push_back(CL_QUEUE_PROPERTIES);
+        p.push_back(CL_QUEUE_PROFILING_ENABLE);
+    }
+    p.push_back(0);
+    return real_clCreateCommandQueueWithProperties(context, device, p.data(), err);
+}
+
+cl_int clEnqueueWriteBuffer(cl_command_queue q, cl_mem buf, cl_bool blocking, size_t offset, size_t size, const void* ptr,
+                            cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueWriteBuffer);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueWriteBuffer(q, buf, blocking, offset, size, ptr, nWait, wait, evOut);
+    if (tracePath())
+        record(err, q, event, own, "write", size);
+    return err;
+}
+
+cl_int clEnqueueReadBuffer(cl_command_queue q, cl_mem buf, cl_bool blocking, size_t offset, size_t size, void* ptr,
+                           cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueReadBuffer);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueReadBuffer(q, buf, blocking, offset, size, ptr, nWait, wait, evOut);
+    if (tracePath())
+        record(err, q, event, own, "read", size);
+    return err;
+}
+
+cl_int clEnqueueFillBuffer(cl_command_queue q, cl_mem buf, const void* pattern, size_t patternSize, size_t offset, size_t size,
+                           cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueFillBuffer);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueFillBuffer(q, buf, pattern, patternSize, offset, size, nWait, wait, evOut);
+    if (tracePath())
+        record(err, q, event, own, "fill", size);
+    return err;
+}
+
+cl_int clEnqueueCopyBuffer(cl_command_queue q, cl_mem src, cl_mem dst, size_t srcOffset, size_t dstOffset, size_t size,
+                           cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueCopyBuffer);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueCopyBuffer(q, src, dst, srcOffset, dstOffset, size, nWait, wait, evOut);
+    if (tracePath())
+        record(err, q, event, own, "copy", size);
+    return err;
+}
+
+void* clEnqueueMapBuffer(cl_command_queue q, cl_mem buf, cl_bool blocking, cl_map_flags flags, size_t offset, size_t size,
+                         cl_uint nWait, const cl_event* wait, cl_event* event, cl_int* errOut) {
+    REAL(clEnqueueMapBuffer);
+    TRACE_EVENT;
+    cl_int err;
+    void* p = real_clEnqueueMapBuffer(q, buf, blocking, flags, offset, size, nWait, wait, evOut, &err);
+    if (errOut)
+        *errOut = err;
+    if (tracePath())
+        record(err, q, event, own, "map", size);
+    return p;
+}
+
+cl_int clEnqueueUnmapMemObject(cl_command_queue q, cl_mem mem, void* ptr, cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueUnmapMemObject);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueUnmapMemObject(q, mem, ptr, nWait, wait, evOut);
+    if (tracePath())
+        record(err, q, event, own, "unmap", 0);
+    return err;
+}
+
+cl_int clEnqueueWriteImage(cl_command_queue q, cl_mem img, cl_bool blocking, const size_t* origin, const size_t* region,
+                           size_t rowPitch, size_t slicePitch, const void* ptr, cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueWriteImage);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueWriteImage(q, img, blocking, origin, region, rowPitch, slicePitch, ptr, nWait, wait, evOut);
+    if (tracePath()) {
+        size_t elem = 0;
+        clGetImageInfo(img, CL_IMAGE_ELEMENT_SIZE, sizeof(elem), &elem, nullptr);
+        record(err, q, event, own, "write image", elem * region[0] * region[1] * region[2]);
+    }
+    return err;
+}
+
+cl_int clEnqueueReadImage(cl_command_queue q, cl_mem img, cl_bool blocking, const size_t* origin, const size_t* region,
+                          size_t rowPitch, size_t slicePitch, void* ptr, cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueReadImage);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueReadImage(q, img, blocking, origin, region, rowPitch, slicePitch, ptr, nWait, wait, evOut);
+    if (tracePath()) {
+        size_t elem = 0;
+        clGetImageInfo(img, CL_IMAGE_ELEMENT_SIZE, sizeof(elem), &elem, nullptr);
+        record(err, q, event, own, "read image", elem * region[0] * region[1] * region[2]);
+    }
+    return err;
+}
+
+cl_int clEnqueueNDRangeKernel(cl_command_queue q, cl_kernel kernel, cl_uint dim, const size_t* offset, const size_t* global,
+                              const size_t* local, cl_uint nWait, const cl_event* wait, cl_event* event) {
+    REAL(clEnqueueNDRangeKernel);
+    TRACE_EVENT;
+    cl_int err = real_clEnqueueNDRangeKernel(q, kernel, dim, offset, global, local, nWait, wait, evOut);
+    if (tracePath() && err == CL_SUCCESS) {
+        char name[128] = "kernel";
+        clGetKernelInfo(kernel, CL_KERNEL_FUNCTION_NAME, sizeof(name), name, nullptr);
+        size_t groups = local ? 1 : 0, wg = local ? 1 : 0;
+        for (cl_uint d = 0; local && d < dim; d++) {
+            groups *= (global[d] + local[d] - 1) / local[d];
+            wg *= local[d];
+        }
+        cl_ulong localMem = 0;
+        cl_device_id dev;
+        if (clGetCommandQueueInfo(q, CL_QUEUE_DEVICE, sizeof(dev), &dev, nullptr) == CL_SUCCESS)
+            clGetKernelWorkGroupInfo(kernel, dev, CL_KERNEL_LOCAL_MEM_SIZE, sizeof(localMem), &localMem, nullptr);
+        record(err, q, event, own, name, 0, groups, wg, localMem);
+    }
+    return err;
+}
+
+}
@@ -0,0 +1,119 @@
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <cmath>
+#include "hetSched.hpp"
+
+/*
+    CPU + OpenCL work splitting (hetSched.hpp) on 3 workloads
+    ./hetSched [all|vecadd|zernike|lcs] [scale=1]
+    Each: host threads only, devices only, then split twice (the 2nd run starts from the learned rates),
+    checked against the host result. Synthetic inputs, no image files needed.
+    Runs on POCL alone: HET_DEVICES picks the devices, HET_HOST=0 drops the host worker.
+*/
+
+#define VEC_N (1 << 26)
+#define IMG_W 1920
+#define IMG_H 1080
+#define LCS_PAIRS 4096
+#define LCS_LEN 1000
+
+// host only, devices only, split x 2
+template <typename Run, typename Check>
+static void compare(HetScheduler& s, const char* name, Run run, Check check) {
+    const char* label[] = { "host only", "devices only", "split", "split again" };
+    bool host[] = { true, false, true, true };
+    bool devs[] = { false, true, true, true };
+    for (int k = 0; k < 4; k++) {
+        if (!host[k] && s.devices() == 0)
+            continue;
+        s.use(host[k], devs[k]);
+        double t = run();
+        size_t bad = check();
+        std::cout << name << ", " << label[k] << ": " << t * 1e3 << " ms" << (bad ? ", " + std::to_string(bad) + " mismatches" : "")
+                  << std::endl;
+        if (k >= 2)
+            s.report();
+    }
+    s.use(true, true);
+}
+
+int main(int argc, char** argv) {
+    std::string which = argc > 1 ? argv[1] : "all";
+    double scale = argc > 2 ? atof(argv[2]) : 1.0;
+
+    HetScheduler sched;
+    std::cout << sched.devices() << " device(s):";
+    for (size_t d = 0; d < sched.devices(); d++)
+        std::cout << " [" << d << "] " << sched.device(d).name();
+    std::cout << std::endl;
+
+    if (which == "all" || which == "vecadd") {
+        size_t n = VEC_N * scale;
+        std::vector<int> A(n), B(n), C(n), D(n);
+        for (size_t i = 0; i < n; i++) {
+            A[i] = i & 0xFFFF;
+            B[i] = 2 * A[i];
+            C[i] = 3 * A[i];
+        }
+        HetVecAdd job(sched);
+        compare(sched, "vecadd",
+            [&] { std::fill(D.begin(), D.end(), -1); return job.run(A.data(), B.data(), C.data(), D.data(), n); },
+            [&] {
+                size_t bad = 0;
+                for (size_t i = 0; i < n; i++)
+                    bad += D[i] != 6 * A[i];
+                return bad;
+            });
+    }
+
+    if (which == "all" || which == "zernike") {
+        // Discs & a ramp: edges in every direction
+        int w = IMG_W * std::sqrt(scale), h = IMG_H * std::sqrt(scale);
+        std::vector<unsigned char> img(w * h), ref(w * h), out(w * h);
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) {
+                int cx = x % 200 - 100, cy = y % 200 - 100;
+                img[y * w + x] = cx * cx + cy * cy < 60 * 60 ? 220 : 40 + x * 60 / w;
+            }
+        int order = 4, N = 7;
+        HetZernike job(sched, order, N, 0.1f, 0.5f);
+        zernikeHost(zernikeHostSetup(order, N, 0.1f, 0.5f), img.data(), ref.data(), w, h, 0, h);
+        compare(sched, "zernike",
+            [&] { std::fill(out.begin(), out.end(), 0); return job.run(img.data(), out.data(), w, h); },
+            [&] {
+                size_t bad = 0;
+                for (int i = 0; i < w * h; i++)
+                    bad += std::abs(out[i] - ref[i]) > 1; // kernel vs host float rounding
+                return bad;
+            });
+    }
+
+    if (which == "all" || which == "lcs") {
+        std::mt19937 rng(42);
+        SeqPack pack;
+        std::vector<int> pairs, lens, ref;
+        int nPairs = LCS_PAIRS * scale;
+        for (int p = 0; p < nPairs; p++) {
+            std::string a(LCS_LEN / 2 + rng() % LCS_LEN, ' '), b(LCS_LEN / 2 + rng() % LCS_LEN, ' ');
+            for (char& c : a) c = "ACGT"[rng() % 4];
+            for (char& c : b) c = "ACGT"[rng() % 4];
+            pairs.push_back(pack.add(a));
+            pairs.push_back(pack.add(b));
+        }
+        lcsBatchHost(pack, pairs, ref);
+        HetLcs job(sched);
+        compare(sched, "lcs",
+            [&] { return job.run(pack, pairs, lens); },
+            [&] {
+                size_t bad = 0;
+                for (int p = 0; p < nPairs; p++)
+                    bad += lens[p] != ref[p];
+                return bad;
+            });
+    }
+    return 0;
+}
@@ -0,0 +1,355 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <omp.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "clRuntime.hpp"
+#include "LCSbitpar.hpp"
+#include "LCSbatch.hpp"
+#include "zernikeKernels.hpp"
+
+/*
+    Heterogeneous work splitting: OpenMP host threads + every OpenCL device, all busy at once
+    HetScheduler::run(key, n, host, dev): items [0, n) handed out in chunks from 1 shared cursor.
+    - 1 std::thread per device (blocking enqueue / read of its chunk), the host worker on the calling thread
+      (OpenMP over its chunk, 1 core left per device thread)
+    - chunk = the worker's share of what is left, by measured throughput (items/s, EWMA, transfers included),
+      / HET_GUIDE & capped at HET_CHUNK_MS of work: chunks shrink towards the end, so workers finish together
+    - rates are kept per key across runs: the 2nd run starts from the right split
+    HET_DEVICES=all (default: deviceSet(), NUMA sub-devices included) | none | 0,2,... (indices into
+    allDevices()), HET_HOST=0: devices only.
+    With only the POCL CPU device, POCL & the host threads share the cores and the rates settle the split.
+
+    Jobs: HetVecAdd (elementwise), HetZernike (image rows, halo rows sent along), HetLcs (batched pairs).
+*/
+
+#define HET_FIRST_DIV 64  // first chunk, rate unknown: n / (HET_FIRST_DIV * workers)
+#define HET_GUIDE 2       // chunk = rate share of the rest / HET_GUIDE
+#define HET_CHUNK_MS 50   // chunk cap: ms of work at the worker's rate
+#define HET_EWMA 0.5      // weight of the newest rate sample
+
+struct HetStat {
+    std::string name;
+    size_t items = 0, chunks = 0;
+    double busy = 0, finish = 0; // s: in work, until the last chunk was done
+    double rate = 0;             // items/s after this run
+};
+
+class HetScheduler {
+public:
+    HetScheduler() {
+        std::vector<cl::Device> all = allDevices();
+        const char* env = getenv("HET_DEVICES");
+        std::string sel = env ? env : "all";
+        if (sel == "all") {
+            for (const cl::Device& d : deviceSet())
+                devs_.emplace_back(d);
+        }
+        else if (sel != "none") {
+            for (size_t p = 0; p < sel.size();) {
+                size_t i = strtoul(sel.c_str() + p, nullptr, 10);
+                if (i < all.size())
+                    devs_.emplace_back(all[i]);
+                p = sel.find(',', p);
+                p = p == std::string::npos ? sel.size() : p + 1;
+            }
+        }
+        const char* h = getenv("HET_HOST");
+        useHost_ = !(h && !strcmp(h, "0")) || devs_.empty();
+        hostThreads_ = std::max(1, omp_get_num_procs() - (int)devs_.size());
+    }
+
+    size_t devices() const { return devs_.size(); }
+    ClDevice& device(size_t d) { return devs_[d]; }
+
+    // Restrict the next runs (e.g. host-only / device-only baselines). At least 1 worker stays on
+    void use(bool host, bool devices) {
+        useHost_ = host || !devices || devs_.empty();
+        useDevs_ = devices && !devs_.empty();
+    }
+
+    // Forget the measured rates of key ("" = all)
+    void reset(const std::string& key = "") {
+        if (key.empty())
+            rates_.clear();
+        else
+            rates_.erase(key);
+    }
+
+    // host(lo, hi): items [lo, hi) on the calling thread, may use OpenMP.
+    // dev(d, lo, hi): items [lo, hi) on device d, blocking, called from d's worker thread.
+    // Chunks are multiples of grain (but the last). Returns the wall time (s)
+    template <typename HostFn, typename DevFn>
+    double run(const std::string& key, size_t n, HostFn host, DevFn dev, size_t grain = 1) {
+        size_t nw = devs_.size() + 1; // workers 0..D-1: devices, D: host
+        std::vector<double>& rate = rates_[key];
+        rate.resize(nw, 0.0);
+        std::vector<bool> on(nw);
+        for (size_t w = 0; w < nw; w++)
+            on[w] = w + 1 < nw ? useDevs_ : useHost_;
+        stats_.assign(nw, HetStat());
+        for (size_t w = 0; w < nw; w++)
+            stats_[w].name = w + 1 < nw ? devs_[w].name() : "host (" + std::to_string(hostThreads_) + " threads)";
+
+        size_t next = 0;
+        std::mutex mu;
+        auto start = std::chrono::steady_clock::now();
+        auto now = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+        // Next chunk of worker w into [lo, hi), false when all is handed out
+        auto grab = [&](size_t w, size_t& lo, size_t& hi) {
+            std::lock_guard<std::mutex> lk(mu);
+            if (next >= n)
+                return false;
+            size_t rest = n - next, active = 0;
+            double sum = 0, known = 0;
+            for (size_t v = 0; v < nw; v++)
+                if (on[v]) {
+                    active++;
+                    sum += rate[v];
+                    known += rate[v] > 0;
+                }
+            size_t cnt;
+            if (rate[w] <= 0)
+                cnt = n / (HET_FIRST_DIV * active);
+            else {
+                sum += (active - known) * (sum / known); // workers not measured yet: the average
+                cnt = std::min<double>(rest * rate[w] / sum / HET_GUIDE, rate[w] * HET_CHUNK_MS * 1e-3);
+            }
+            cnt = std::max(grain, (cnt + grain - 1) / grain * grain);
+            lo = next;
+            hi = next = lo + std::min(cnt, rest);
+            return true;
+        };
+        auto account = [&](size_t w, size_t lo, size_t hi, double t0) {
+            double t = now(), dt = std::max(t - t0, 1e-9);
+            double r = (hi - lo) / dt;
+            std::lock_guard<std::mutex> lk(mu);
+            rate[w] = rate[w] > 0 ? HET_EWMA * r + (1 - HET_EWMA) * rate[w] : r;
+            HetStat& s = stats_[w];
+            s.items += hi - lo;
+            s.chunks++;
+            s.busy += dt;
+            s.finish = t;
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t d = 0; d + 1 < nw; d++)
+            if (on[d])
+                threads.emplace_back([&, d] {
+                    size_t lo, hi;
+                    while (grab(d, lo, hi)) {
+                        double t0 = now();
+                        dev(d, lo, hi);
+                        account(d, lo, hi, t0);
+                    }
+                });
+        if (on[nw - 1]) {
+            int saved = omp_get_max_threads();
+            omp_set_num_threads(useDevs_ ? hostThreads_ : omp_get_num_procs());
+            size_t lo, hi;
+            while (grab(nw - 1, lo, hi)) {
+                double t0 = now();
+                host(lo, hi);
+                account(nw - 1, lo, hi, t0);
+            }
+            omp_set_num_threads(saved);
+        }
+        for (std::thread& t : threads)
+            t.join();
+        double t = now();
+        for (size_t w = 0; w < nw; w++)
+            stats_[w].rate = rate[w];
+        return t;
+    }
+
+    const std::vector<HetStat>& stats() const { return stats_; }
+
+    // Share, chunks, rate & finish time per worker of the last run
+    void report(std::ostream& os = std::cout) const {
+        double first = 1e30, last = 0;
+        size_t total = 0;
+        for (const HetStat& s : stats_)
+            total += s.items;
+        for (const HetStat& s : stats_) {
+            if (!s.chunks)
+                continue;
+            first = std::min(first, s.finish);
+            last = std::max(last, s.finish);
+            os << "  " << std::left << std::setw(32) << s.name.substr(0, 31) << std::right << std::setw(6) << std::fixed
+               << std::setprecision(1) << 100.0 * s.items / std::max<size_t>(1, total) << "%  " << std::setw(5) << s.chunks
+               << " chunks  " << std::setprecision(3) << s.rate * 1e-6 << " M items/s  busy " << s.busy << " s, done at "
+               << s.finish << " s" << std::defaultfloat << std::endl;
+        }
+        if (last > 0)
+            os << "  finish spread: " << (last - first) * 1e3 << " ms" << std::endl;
+    }
+
+private:
+    std::deque<ClDevice> devs_; // deque: ClDevice holds a mutex
+    std::map<std::string, std::vector<double>> rates_;
+    std::vector<HetStat> stats_;
+    bool useHost_ = true, useDevs_ = true;
+    int hostThreads_ = 1;
+};
+
+
+
+// ------ Elementwise: D = A + B + C ------
+inline const char* const hetAddKern = R"(
+__kernel void hetAdd(__global const int* A, __global const int* B, __global const int* C, __global int* D, const uint n) {
+    size_t i = get_global_id(0);
+    if (i < n)
+        D[i] = A[i] + B[i] + C[i];
+}
+)";
+
+class HetVecAdd {
+public:
+    explicit HetVecAdd(HetScheduler& s) : s_(s), devs_(s.devices()) {
+        for (size_t d = 0; d < devs_.size(); d++)
+            devs_[d].kern = cl::Kernel(s_.device(d).program(hetAddKern), "hetAdd");
+    }
+
+    double run(const int* A, const int* B, const int* C, int* D, size_t n) {
+        return s_.run("vecadd", n,
+            [&](size_t lo, size_t hi) {
+                #pragma omp parallel for simd schedule(static)
+                for (size_t i = lo; i < hi; i++)
+                    D[i] = A[i] + B[i] + C[i];
+            },
+            [&](size_t d, size_t lo, size_t hi) {
+                PerDev& p = devs_[d];
+                ClDevice& dev = s_.device(d);
+                cl::CommandQueue& q = dev.queue();
+                size_t cnt = hi - lo, bytes = cnt * sizeof(int);
+                for (int j = 0; j < 3; j++)
+                    reserveBuffer(dev.context(), p.in[j], p.capIn[j], bytes, CL_MEM_READ_ONLY);
+                reserveBuffer(dev.context(), p.out, p.capOut, bytes, CL_MEM_WRITE_ONLY);
+                const int* src[3] = { A, B, C };
+                for (int j = 0; j < 3; j++)
+                    q.enqueueWriteBuffer(p.in[j], CL_FALSE, 0, bytes, src[j] + lo);
+                for (int j = 0; j < 3; j++)
+                    p.kern.setArg(j, p.in[j]);
+                p.kern.setArg(3, p.out);
+                p.kern.setArg(4, (cl_uint)cnt);
+                q.enqueueNDRangeKernel(p.kern, cl::NullRange, cl::NDRange((cnt + 63) / 64 * 64), cl::NDRange(64));
+                q.enqueueReadBuffer(p.out, CL_TRUE, 0, bytes, D + lo);
+            },
+            64);
+    }
+
+private:
+    struct PerDev {
+        cl::Kernel kern;
+        cl::Buffer in[3], out;
+        size_t capIn[3] = {}, capOut = 0;
+    };
+    HetScheduler& s_;
+    std::vector<PerDev> devs_;
+};
+
+
+
+// ------ Zernike: image rows ------
+// Device chunk: rows [lo, hi) through ZernikeStrip (N / 2 halo rows each side), read back before returning
+class HetZernike {
+public:
+    HetZernike(HetScheduler& s, int order, int N, float kThr, float lThr)
+        : s_(s), devs_(s.devices()), host_(zernikeHostSetup(order, N, kThr, lThr)) {
+        for (size_t d = 0; d < devs_.size(); d++)
+            devs_[d].zk = zernikeKernels(s_.device(d), order, N, kThr, lThr);
+    }
+
+    double run(const unsigned char* image, unsigned char* out, int width, int height) {
+        return s_.run("zernike", height,
+            [&](size_t lo, size_t hi) { zernikeHost(host_, image, out, width, height, lo, hi); },
+            [&](size_t d, size_t lo, size_t hi) {
+                ClDevice& dev = s_.device(d);
+                devs_[d].run(dev.context(), dev.queue(), image, out, width, height, lo, hi, true);
+            });
+    }
+
+private:
+    HetScheduler& s_;
+    std::vector<ZernikeStrip> devs_;
+    ZernikeKernels host_;
+};
+
+
+
+// ------ LCS: batched pairs ------
+// The pack goes to every device once per run, then pair chunks. Pairs over LCS_BATCH_MAXLEN come back
+// as -1 from the device and are finished by its worker thread
+class HetLcs {
+public:
+    explicit HetLcs(HetScheduler& s) : s_(s), devs_(s.devices()) {
+        std::string opts = "-D MAXLEN=" + std::to_string(LCS_BATCH_MAXLEN);
+        for (size_t d = 0; d < devs_.size(); d++) {
+            devs_[d].kern = cl::Kernel(s_.device(d).program(lcsBatchKern, opts), "lcs_batch");
+            devs_[d].wg = std::min<size_t>(LCS_BATCH_WG, s_.device(d).device().getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+        }
+    }
+
+    double run(const SeqPack& pack, const std::vector<int>& pairs, std::vector<int>& lens) {
+        size_t nPairs = pairs.size() / 2;
+        lens.assign(nPairs, 0);
+        for (PerDev& p : devs_)
+            p.packed = false;
+        return s_.run("lcs", nPairs,
+            [&](size_t lo, size_t hi) {
+                #pragma omp parallel for schedule(dynamic, 16)
+                for (long p = lo; p < (long)hi; p++)
+                    lens[p] = lcsLengthBitpar(pack[pairs[2 * p]], pack[pairs[2 * p + 1]]);
+            },
+            [&](size_t d, size_t lo, size_t hi) {
+                PerDev& p = devs_[d];
+                ClDevice& dev = s_.device(d);
+                cl::CommandQueue& q = dev.queue();
+                if (!p.packed) {
+                    reserveBuffer(dev.context(), p.seqs, p.capSeqs, std::max<size_t>(1, pack.seqs.size()), CL_MEM_READ_ONLY);
+                    reserveBuffer(dev.context(), p.offs, p.capOffs, pack.offs.size() * sizeof(int), CL_MEM_READ_ONLY);
+                    if (!pack.seqs.empty())
+                        q.enqueueWriteBuffer(p.seqs, CL_FALSE, 0, pack.seqs.size(), pack.seqs.data());
+                    q.enqueueWriteBuffer(p.offs, CL_FALSE, 0, pack.offs.size() * sizeof(int), pack.offs.data());
+                    p.packed = true;
+                }
+                size_t cnt = hi - lo;
+                reserveBuffer(dev.context(), p.pairs, p.capPairs, 2 * cnt * sizeof(int), CL_MEM_READ_ONLY);
+                reserveBuffer(dev.context(), p.lens, p.capLens, cnt * sizeof(int), CL_MEM_WRITE_ONLY);
+                q.enqueueWriteBuffer(p.pairs, CL_FALSE, 0, 2 * cnt * sizeof(int), pairs.data() + 2 * lo);
+                p.kern.setArg(0, p.seqs);
+                p.kern.setArg(1, p.offs);
+                p.kern.setArg(2, p.pairs);
+                p.kern.setArg(3, p.lens);
+                q.enqueueNDRangeKernel(p.kern, cl::NullRange, cl::NDRange(cnt * p.wg), cl::NDRange(p.wg));
+                q.enqueueReadBuffer(p.lens, CL_TRUE, 0, cnt * sizeof(int), lens.data() + lo);
+                for (size_t i = lo; i < hi; i++)
+                    if (lens[i] < 0)
+                        lens[i] = lcsLengthBitpar(pack[pairs[2 * i]], pack[pairs[2 * i + 1]]);
+            },
+            16);
+    }
+
+private:
+    struct PerDev {
+        cl::Kernel kern;
+        size_t wg = 1;
+        bool packed = false;
+        cl::Buffer seqs, offs, pairs, lens;
+        size_t capSeqs = 0, capOffs = 0, capPairs = 0, capLens = 0;
+    };
+    HetScheduler& s_;
+    std::vector<PerDev> devs_;
+};
@@ -1,6 +1,7 @@
 #include <CL/cl2.hpp>
 #include <iostream>
 #include <vector>
+#include "clRuntime.hpp"
 
 #define SIZE 10
 
@@ -30,36 +31,21 @@ const char* kern = R"(
 
 int main() {
     // ------ Sys env ------
-    std::vector<cl::Platform> all_platforms;
-    cl::Platform::get(&all_platforms);
-
-    cl::Platform plat = all_platforms[0];
-    // Platform
-    std::cout << plat.getInfo<CL_PLATFORM_NAME>() << std::endl;
-
-
-    std::vector<cl::Device> all_devices;
-    plat.getDevices(CL_DEVICE_TYPE_ALL, &all_devices);
-    if (all_devices.size() == 0) {
-        std::cout << " No devices found.\n";
-        exit(1);
-    }
-
-    for (const auto& device : all_devices) {
+    for (const auto& device : allDevices()) {
         printDeviceInfo(device);
     }
 
-    cl::Device dev = all_devices[0];
+    // Device picked by policy (type, #CU, memory) over all platforms, CL_DEVICE env overrides
+    ClRuntime& rt = ClRuntime::get();
+    cl::Device dev = rt.device();
     std::cout << "Using device: " << dev.getInfo<CL_DEVICE_NAME>() << std::endl;
     std::cout << "#CU: " << dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() << std::endl;
     std::cout << "Memory size: " << dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() << std::endl;
 
 
-    // ------ Create context & sources ------
+    // ------ Context ------
     
-    // Context: inter-device mem. share
-    cl::Context contxt({ dev });
-    cl::Program::Sources src;
+    // Context: inter-device mem. share, long-lived in the runtime: rt.context()
 
     // ------ Input ------
     // Host 
@@ -68,19 +54,22 @@ int main() {
 
     // ------ Buffer setup ------
 
-    // Buffer: mem allo. to the dev.
+    // Buffer: mem allo. to the dev., recycled by the runtime's pool
     // Image: 2D/3D buffer
-    cl::Buffer buf_A(contxt, CL_MEM_READ_ONLY, sizeof(int) * SIZE);
-    cl::Buffer buf_B(contxt, CL_MEM_READ_ONLY, sizeof(int) * SIZE);
+    PooledBuffer pA = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_ONLY);
+    const cl::Buffer& buf_A = *pA;
+    PooledBuffer pB = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_ONLY);
+    const cl::Buffer& buf_B = *pB;
     
-    cl::Buffer buf_C(contxt, CL_MEM_READ_WRITE, sizeof(int) * SIZE);
+    PooledBuffer pC = rt.pool().acquire(sizeof(int) * SIZE, CL_MEM_READ_WRITE);
+    const cl::Buffer& buf_C = *pC;
     // CL_MEM_READ(WRITE)_ONLY / CL_MEM_READ_WRITE
 
 
     // ------ Command (Task) Queue ------
     // Queue: push cmd onto Dev, ~= CUDA streams
-    // queue for each dev
-    cl::CommandQueue qu(contxt, dev);
+    // queue for each dev, created with CL_QUEUE_PROFILING_ENABLE (for ekern0 below)
+    cl::CommandQueue& qu = rt.queue();
     // Read/Write/Map/Copy
     // blocking = CL_TRUE for sync
     qu.enqueueWriteBuffer(buf_A, CL_TRUE, 0, sizeof(int) * SIZE, A_h);
@@ -88,16 +77,10 @@ int main() {
 	
     // ------ Run kernel in source ------
 
-    // push kern to the source code
-    src.push_back({ kern, strlen(kern) });
-    // OpenCL prog: link src to context
-    cl::Program prog(contxt, src);
-
-    // check build
-    if (prog.build({ dev }) != CL_SUCCESS) {
-        std::cout << " Error building: " << prog.getBuildInfo<CL_PROGRAM_BUILD_LOG>(dev) << std::endl;
-        exit(1);
-    }
+    // OpenCL prog: built from kern once, then loaded from the binary cache
+    ClCacheStat buildStat;
+    cl::Program prog = rt.program(kern, "", &buildStat);
+    printCacheStat(buildStat);
     // get_global_id, get_global_size, get_work_dim, get+
     // https://registry.khronos.org/OpenCL/sdk/3.0/docs/man/html/get_work_dim.html
     // https://community.khronos.org/t/when-to-use-get-global-id-and-get-local-id-in-opencl/3999/4
@@ -141,24 +124,3 @@ int main() {
 
     return 0;
 }
-
-
-void printDeviceInfo(const cl::Device& device) {
-    std::cout << "  Device Name: " << device.getInfo<CL_DEVICE_NAME>() << "\n";
-    std::cout << "  Device Type: ";
-    switch (device.getInfo<CL_DEVICE_TYPE>()) {
-    case CL_DEVICE_TYPE_CPU: std::cout << "CPU"; break;
-    case CL_DEVICE_TYPE_GPU: std::cout << "GPU"; break;
-    case CL_DEVICE_TYPE_ACCELERATOR: std::cout << "Accelerator"; break;
-    default: std::cout << "Other"; break;
-    }
-    std::cout << "\n";
-
-    std::cout << "  Compute Units: " << device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() << "\n";
-    std::cout << "  Global Memory: " << device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / (1024 * 1024) << " MB\n";
-    std::cout << "  Local Memory: " << device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() / 1024 << " KB\n";
-    std::cout << "  Max Work Group Size: " << device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() << "\n";
-    std::cout << "  Max Clock Frequency: " << device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>() << " MHz\n";
-    std::cout << "----------------------------------------\n";
-}
-
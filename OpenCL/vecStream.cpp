@@ -0,0 +1,46 @@
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include "vecStream.hpp"
+
+/*
+    D = A + B + C over n ints, chunked & pipelined (vecStream.hpp)
+    ./vecStream [n] [inputs=3] [width=8]
+    Inputs are generated straight into the mapped chunks and the result is checked as it is drained,
+    so n is not bounded by host or device memory (e.g. 4000000000).
+*/
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : (size_t)1 << 28;
+    int nIn = argc > 2 ? atoi(argv[2]) : 3;
+    int vw = argc > 3 ? atoi(argv[3]) : 8;
+
+    ClRuntime& rt = ClRuntime::get();
+    std::cout << "Using device: " << rt.device().getInfo<CL_DEVICE_NAME>() << "\n";
+    VecStream stream(nIn, vw, 0, rt);
+    std::cout << "n = " << n << ", " << nIn << " inputs, int" << vw << ", chunk " << stream.chunk() << " ints ("
+              << (n + stream.chunk() - 1) / stream.chunk() << " chunks)\n";
+
+    // A[i] = i mod 2^16, B = 2A, C = 3A
+    size_t bad = 0;
+    double t = stream.run(n,
+        [&](int** in, size_t off, size_t cnt) {
+            for (int j = 0; j < nIn; j++) {
+                #pragma omp parallel for
+                for (long i = 0; i < (long)cnt; i++)
+                    in[j][i] = (int)((off + i) & 0xFFFF) * (j + 1);
+            }
+        },
+        [&](const int* out, size_t off, size_t cnt) {
+            int mul = nIn == 3 ? 6 : 3;
+            #pragma omp parallel for reduction(+: bad)
+            for (long i = 0; i < (long)cnt; i++)
+                bad += out[i] != (int)((off + i) & 0xFFFF) * mul;
+        });
+
+    double gb = (double)n * (nIn + 1) * sizeof(int) * 1e-9;
+    std::cout << "Time: " << t << " s, " << gb / t << " GB/s (host fill & check included)\n";
+    std::cout << "Mismatches: " << bad << std::endl;
+    return bad != 0;
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <CL/cl2.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include "clRuntime.hpp"
+
+/*
+    Streaming vector add for arrays of any length (billions of ints, larger than device memory)
+    D = A + B (kern0) or D = A + B + C (_3arrAdd), chunk by chunk:
+    - kernel: VW ints per vloadVW / vstoreVW (VW = 4, 8, 16), grid-stride loop, so the NDRange is sized
+      to the device (STREAM_WAVES work-groups per compute unit), not to the chunk
+    - buffers: CL_MEM_ALLOC_HOST_PTR (pinned / shared host memory), mapped instead of read / written:
+      fill() writes the inputs straight into the mapped chunk, drain() reads the mapped result.
+      Zero-copy where host & device share memory, DMA from pinned pages otherwise
+    - STREAM_SETS chunk buffer sets on as many in-order queues: the host fills chunk k + 1 & drains k - 1
+      while the device adds chunk k
+    Chunk: STREAM_CHUNK ints if set, else as large as max. alloc. & half the device memory allow.
+*/
+
+#define STREAM_SETS 2
+#define STREAM_WAVES 4
+#define STREAM_WG 256
+
+inline const char* const vecStreamKern = R"(
+// NIN = 2: C is unused
+__kernel void addStream(__global const int* A, __global const int* B, __global const int* C, __global int* D, const ulong n) {
+    size_t nv = n / VW;
+    for (size_t i = get_global_id(0); i < nv; i += get_global_size(0)) {
+        VT s = VLOAD(i, A) + VLOAD(i, B);
+#if NIN == 3
+        s += VLOAD(i, C);
+#endif
+        VSTORE(s, i, D);
+    }
+    // tail: < VW elements
+    for (size_t j = nv * VW + get_global_id(0); j < n; j += get_global_size(0)) {
+        int s = A[j] + B[j];
+#if NIN == 3
+        s += C[j];
+#endif
+        D[j] = s;
+    }
+}
+)";
+
+
+
+class VecStream {
+public:
+    // nIn: 2 or 3 inputs, vw: ints per vector load, chunk: ints per chunk (0: from the device limits)
+    explicit VecStream(int nIn = 3, int vw = 8, size_t chunk = 0, ClRuntime& rt = ClRuntime::get())
+        : rt_(rt), nIn_(nIn), vw_(vw) {
+        if ((nIn != 2 && nIn != 3) || (vw != 4 && vw != 8 && vw != 16)) {
+            std::cout << " VecStream: need 2 or 3 inputs and a width of 4, 8 or 16.\n";
+            exit(1);
+        }
+        const cl::Device& dev = rt_.device();
+        if (const char* env = getenv("STREAM_CHUNK"))
+            chunk = strtoull(env, nullptr, 10);
+        if (chunk == 0) {
+            size_t maxAlloc = dev.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+            size_t mem = dev.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() / 2;
+            chunk = std::min(maxAlloc, mem / (STREAM_SETS * (nIn + 1))) / sizeof(int);
+        }
+        chunk_ = std::max<size_t>(vw, chunk / vw * vw);
+
+        std::string opts = "-D NIN=" + std::to_string(nIn) + " -D VW=" + std::to_string(vw) +
+                           " -D VT=int" + std::to_string(vw) + " -D VLOAD=vload" + std::to_string(vw) +
+                           " -D VSTORE=vstore" + std::to_string(vw);
+        kern_ = cl::Kernel(rt_.program(vecStreamKern, opts), "addStream");
+        wg_ = std::min<size_t>(STREAM_WG, dev.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>());
+        groups_ = (size_t)dev.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>() * STREAM_WAVES;
+
+        for (int s = 0; s < STREAM_SETS; s++) {
+            for (int j = 0; j < nIn_; j++)
+                in_[s][j] = rt_.pool().acquire(chunk_ * sizeof(int), CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR);
+            out_[s] = rt_.pool().acquire(chunk_ * sizeof(int), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR);
+        }
+    }
+
+    size_t chunk() const { return chunk_; }
+
+    // fill(int* in[], off, cnt): inputs j, elements [off, off + cnt) into in[j][0, cnt)
+    // drain(const int* out, off, cnt): result elements [off, off + cnt)
+    // Both on the calling thread, in chunk order. Returns the wall time (s)
+    template <typename Fill, typename Drain>
+    double run(size_t n, Fill fill, Drain drain) {
+        auto start = std::chrono::steady_clock::now();
+        cl::CommandQueue* qs[STREAM_SETS];
+        for (int s = 0; s < STREAM_SETS; s++)
+            qs[s] = &rt_.queue(s);
+
+        int* outMap[STREAM_SETS] = {};
+        size_t outOff[STREAM_SETS], outCnt[STREAM_SETS];
+        cl::Event outEv[STREAM_SETS];
+        auto retire = [&](int s) {
+            outEv[s].wait();
+            drain((const int*)outMap[s], outOff[s], outCnt[s]);
+            qs[s]->enqueueUnmapMemObject(*out_[s], outMap[s]);
+            outMap[s] = nullptr;
+        };
+
+        size_t chunks = (n + chunk_ - 1) / chunk_;
+        for (size_t k = 0; k < chunks; k++) {
+            int s = k % STREAM_SETS;
+            cl::CommandQueue& q = *qs[s];
+            if (outMap[s])
+                retire(s);
+            size_t off = k * chunk_;
+            size_t cnt = std::min(chunk_, n - off);
+
+            // Inputs: the blocking map also waits for the set's previous kernel (same in-order queue)
+            int* in[3];
+            for (int j = 0; j < nIn_; j++)
+                in[j] = (int*)q.enqueueMapBuffer(*in_[s][j], CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, cnt * sizeof(int));
+            fill(in, off, cnt);
+            for (int j = 0; j < nIn_; j++)
+                q.enqueueUnmapMemObject(*in_[s][j], in[j]);
+
+            // arguments are captured at enqueue time
+            kern_.setArg(0, *in_[s][0]);
+            kern_.setArg(1, *in_[s][1]);
+            kern_.setArg(2, *in_[s][nIn_ - 1]);
+            kern_.setArg(3, *out_[s]);
+            kern_.setArg(4, (cl_ulong)cnt);
+            size_t groups = std::min(groups_, (cnt / vw_ + wg_ - 1) / wg_);
+            q.enqueueNDRangeKernel(kern_, cl::NullRange, cl::NDRange(std::max<size_t>(1, groups) * wg_), cl::NDRange(wg_));
+
+            outOff[s] = off;
+            outCnt[s] = cnt;
+            outMap[s] = (int*)q.enqueueMapBuffer(*out_[s], CL_FALSE, CL_MAP_READ, 0, cnt * sizeof(int), nullptr, &outEv[s]);
+            q.flush();
+        }
+        for (size_t k = chunks; k < chunks + STREAM_SETS; k++) // drain in chunk order
+            if (outMap[k % STREAM_SETS])
+                retire(k % STREAM_SETS);
+        for (int s = 0; s < STREAM_SETS; s++)
+            qs[s]->finish();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Arrays already in host memory: 1 copy into the mapped chunk & 1 out. C unused with 2 inputs
+    double run(const int* A, const int* B, const int* C, int* D, size_t n) {
+        const int* src[3] = { A, B, C };
+        return run(n,
+            [&](int** in, size_t off, size_t cnt) {
+                for (int j = 0; j < nIn_; j++)
+                    std::memcpy(in[j], src[j] + off, cnt * sizeof(int));
+            },
+            [&](const int* out, size_t off, size_t cnt) { std::memcpy(D + off, out, cnt * sizeof(int)); });
+    }
+
+private:
+    ClRuntime& rt_;
+    int nIn_, vw_;
+    size_t chunk_, wg_, groups_;
+    cl::Kernel kern_;
+    PooledBuffer in_[STREAM_SETS][3], out_[STREAM_SETS];
+};
@@ -1,114 +1,420 @@
 #include <CL/cl.h>
 #include <iostream>
 #include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <filesystem>
 #include <opencv2/opencv.hpp>
+#include "zernikeKernels.hpp"
 
-#define CHECK_ERR(x) if (x != CL_SUCCESS) { std::cerr << "OpenCL Error: " << x << std::endl; exit(1); }
+/*
+    Zernike-moment edge detector (Ghosal-Mehrotra), N x N window
+    ./zernikeEdgeDetect [image|dir|video] [order] [N] [flat|tiled|image|bench|multi|points|stack] [outDir=edges]
+    order (>= 2) picks the moments fitted: Z11, Z20 (+ Z31, Z40, ... up to order).
+    Masks & edge LUT are built on host per (order, N) and read from __constant memory.
+    flat: 1 global read per tap. tiled: tile + halo in __local (default). image: same via image2d_t.
+    bench: MP/s of all 3 kernels (BENCH_REPS launches each).
+    multi: rows split over every device & NUMA sub-device (ZernikeMulti), 1 image only.
+    points: threshold, NMS & compaction on the device (ZernikePointList), only the point list is read back;
+            timed against tiled + full readback, points drawn into output.jpg.
+    stack: every (n, m) up to order in 1 pass (ZernikeStack), planar & interleaved, checked against host masks.
+    A directory or video runs the pipeline: frames go to outDir/00000.png, ...
+*/
 
-const char* kernelSource = R"(
-__kernel void computeZernike(__global float *image, __global float *momentOutput, 
-                             int width, int height, int order) {
-    int x = get_global_id(0);
-    int y = get_global_id(1);
+#define BENCH_REPS 20
+#define PIPE_SETS 3     // frames in flight on the device
+#define PIPE_QUEUE 4    // decoded frames waiting for upload
 
-    if (x >= width || y >= height) return;
+// ------ Pipeline: decode thread -> upload / kernel / download (PIPE_SETS in flight) -> encode thread ------
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t cap) : cap_(cap) {}
+    void push(T v) {
+        std::unique_lock<std::mutex> lk(mu_);
+        notFull_.wait(lk, [&] { return q_.size() < cap_; });
+        q_.push_back(std::move(v));
+        notEmpty_.notify_one();
+    }
+    // false once closed & drained
+    bool pop(T& v) {
+        std::unique_lock<std::mutex> lk(mu_);
+        notEmpty_.wait(lk, [&] { return !q_.empty() || closed_; });
+        if (q_.empty())
+            return false;
+        v = std::move(q_.front());
+        q_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+    void close() {
+        std::lock_guard<std::mutex> lk(mu_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+
+private:
+    std::deque<T> q_;
+    size_t cap_;
+    bool closed_ = false;
+    std::mutex mu_;
+    std::condition_variable notFull_, notEmpty_;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Frame {
+    int idx = 0, width = 0, height = 0;
+    cv::Mat data, edges;             // uchar, continuous
+    Clock::time_point t0;            // decode start
+    double ms[6] = {};               // decode, upload, kernel, download, encode, end-to-end
+};
+
+// 1 buffer set: device in/out + the frame they hold, 3 events chained across the queues
+struct PipeSet {
+    PooledBuffer in, out;
+    bool busy = false;
+    Frame frame;
+    cl_event ev[3];
+};
+
+static double eventMs(cl_event ev) {
+    cl_ulong start, end;
+    CHECK_ERR(clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL));
+    CHECK_ERR(clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL));
+    return (end - start) * 1e-6;
+}
+
+static void decodeFrames(const std::string& path, BoundedQueue<Frame>& frames) {
+    std::vector<std::string> files;
+    cv::VideoCapture cap;
+    if (std::filesystem::is_directory(path)) {
+        for (const auto& e : std::filesystem::directory_iterator(path))
+            if (e.is_regular_file())
+                files.push_back(e.path().string());
+        std::sort(files.begin(), files.end());
+    }
+    else
+        cap.open(path);
+
+    int idx = 0;
+    for (size_t f = 0; cap.isOpened() || f < files.size(); f++) {
+        Frame fr;
+        fr.t0 = Clock::now();
+        cv::Mat img;
+        if (cap.isOpened()) {
+            cv::Mat bgr;
+            if (!cap.read(bgr))
+                break;
+            cv::cvtColor(bgr, img, cv::COLOR_BGR2GRAY);
+        }
+        else
+            img = cv::imread(files[f], cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+            continue; // not an image
+        fr.idx = idx++;
+        fr.width = img.cols;
+        fr.height = img.rows;
+        fr.data = img.isContinuous() ? img : img.clone();
+        fr.ms[0] = std::chrono::duration<double, std::milli>(Clock::now() - fr.t0).count();
+        frames.push(std::move(fr));
+    }
+    frames.close();
+}
+
+static void encodeFrames(const std::string& outDir, BoundedQueue<Frame>& done, std::vector<Frame>& stats) {
+    Frame fr;
+    while (done.pop(fr)) {
+        auto t = Clock::now();
+        char name[16];
+        snprintf(name, sizeof(name), "/%05d.png", fr.idx);
+        cv::imwrite(outDir + name, fr.edges);
+        fr.ms[4] = std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+        fr.edges.release();
+        fr.ms[5] = std::chrono::duration<double, std::milli>(Clock::now() - fr.t0).count();
+        stats.push_back(std::move(fr));
+    }
+}
 
-    float Z_real = 0.0f, Z_imag = 0.0f;
-    float rho, theta;
-    
-    int idx = y * width + x;
-    float pixel = image[idx];
+// Wait for the set's download, hand the frame to the encoder
+static void retireSet(PipeSet& s, BoundedQueue<Frame>& done) {
+    CHECK_ERR(clWaitForEvents(1, &s.ev[2]));
+    for (int k = 0; k < 3; k++) {
+        s.frame.ms[k + 1] = eventMs(s.ev[k]);
+        clReleaseEvent(s.ev[k]);
+    }
+    s.frame.data.release();
+    done.push(std::move(s.frame));
+    s.busy = false;
+}
 
-    float cx = width / 2.0f, cy = height / 2.0f;
-    float norm_x = (x - cx) / cx;
-    float norm_y = (y - cy) / cy;
-    rho = sqrt(norm_x * norm_x + norm_y * norm_y);
-    theta = atan2(norm_y, norm_x);
+// Upload, kernel & download of frame i (uchar in & out) run on 3 in-order queues chained by events,
+// so frame i + 1's upload overlaps frame i's kernel and frame i - 1's download
+static void runPipeline(const std::string& path, const std::string& outDir, ClRuntime& rt,
+                        cl_kernel kernel, const size_t* local) {
+    cl_command_queue qs[3] = { rt.queue(0)(), rt.queue(1)(), rt.queue(2)() };
+    std::filesystem::create_directories(outDir);
 
-    if (rho > 1.0f) return;
+    BoundedQueue<Frame> frames(PIPE_QUEUE), done(PIPE_QUEUE);
+    std::vector<Frame> stats;
+    auto start = Clock::now();
+    std::thread decoder(decodeFrames, std::cref(path), std::ref(frames));
+    std::thread encoder(encodeFrames, std::cref(outDir), std::ref(done), std::ref(stats));
 
-    float radial = (2 * pow(rho, 4) - 3 * rho * rho + 1);
-    float basis_real = radial * cos(2 * theta);
-    float basis_imag = radial * sin(2 * theta);
+    PipeSet sets[PIPE_SETS];
+    Frame fr;
+    int n = 0;
+    while (frames.pop(fr)) {
+        PipeSet& s = sets[n++ % PIPE_SETS];
+        if (s.busy)
+            retireSet(s, done);
+        size_t bytes = fr.width * fr.height;
+        if (bytes > s.in.capacity()) { // set retired: the old pair is idle, back to the pool
+            s.in = rt.pool().acquire(bytes, CL_MEM_READ_ONLY);
+            s.out = rt.pool().acquire(bytes, CL_MEM_WRITE_ONLY);
+        }
+        cl_mem in = s.in.get(), out = s.out.get();
+        s.frame = std::move(fr);
+        s.frame.edges.create(s.frame.height, s.frame.width, CV_8UC1);
+        s.busy = true;
 
-    Z_real = pixel * basis_real;
-    Z_imag = pixel * basis_imag;
+        size_t global[] = { static_cast<size_t>(s.frame.width), static_cast<size_t>(s.frame.height) };
+        if (local) {
+            global[0] = (global[0] + local[0] - 1) / local[0] * local[0];
+            global[1] = (global[1] + local[1] - 1) / local[1] * local[1];
+        }
+        CHECK_ERR(clEnqueueWriteBuffer(qs[0], in, CL_FALSE, 0, bytes, s.frame.data.data, 0, NULL, &s.ev[0]));
+        // arguments are captured at enqueue time
+        CHECK_ERR(clSetKernelArg(kernel, 0, sizeof(cl_mem), &in));
+        CHECK_ERR(clSetKernelArg(kernel, 1, sizeof(cl_mem), &out));
+        CHECK_ERR(clSetKernelArg(kernel, 2, sizeof(int), &s.frame.width));
+        CHECK_ERR(clSetKernelArg(kernel, 3, sizeof(int), &s.frame.height));
+        CHECK_ERR(clEnqueueNDRangeKernel(qs[1], kernel, 2, NULL, global, local, 1, &s.ev[0], &s.ev[1]));
+        CHECK_ERR(clEnqueueReadBuffer(qs[2], out, CL_FALSE, 0, bytes, s.frame.edges.data, 1, &s.ev[1], &s.ev[2]));
+        for (cl_command_queue q : qs)
+            clFlush(q);
+    }
+    for (int k = 0; k < PIPE_SETS; k++) { // drain in frame order
+        PipeSet& s = sets[(n + k) % PIPE_SETS];
+        if (s.busy)
+            retireSet(s, done);
+    }
+    done.close();
+    decoder.join();
+    encoder.join();
+    double t = std::chrono::duration<double>(Clock::now() - start).count();
 
-    momentOutput[idx] = sqrt(Z_real * Z_real + Z_imag * Z_imag);
+    // ------ Report ------
+    const char* stage[] = { "decode", "upload", "kernel", "download", "encode", "end-to-end" };
+    std::cout << stats.size() << " frames in " << t << " s: " << stats.size() / t << " FPS" << std::endl;
+    for (int k = 0; k < 6 && !stats.empty(); k++) {
+        double sum = 0, mx = 0;
+        for (const Frame& f : stats) {
+            sum += f.ms[k];
+            mx = std::max(mx, f.ms[k]);
+        }
+        std::cout << "  " << stage[k] << ": mean " << sum / stats.size() << " ms, max " << mx << " ms" << std::endl;
+    }
+    std::cout << "  device allocations: " << rt.pool().allocations() << ", reuses: " << rt.pool().reuses() << std::endl;
 }
-)";
 
-int main() {
-    std::string imgPath = "C:/Users/David/Desktop/zernikeEdgeDetect/assets/genesis.jpg";
-    cv::Mat image = cv::imread(imgPath, cv::IMREAD_GRAYSCALE);
-    if (image.empty()) {
+int main(int argc, char** argv) {
+    std::string imgPath = argc > 1 ? argv[1] : "genesis.jpg";
+    int order = argc > 2 ? atoi(argv[2]) : 4;
+    int N = argc > 3 ? atoi(argv[3]) : 7;
+    std::string mode = argc > 4 ? argv[4] : "tiled";
+    std::string outDir = argc > 5 ? argv[5] : "edges";
+    if (order < 2 || order > 12 || N < 3 || N % 2 == 0) {
+        std::cerr << "Error: need 2 <= order <= 12 and odd N >= 3." << std::endl;
+        return -1;
+    }
+    float kThr = 0.1f;                          // min. step height (intensity in [0, 1])
+    float lThr = std::sqrt(2.0f) / N;           // max. distance from centre: half a pixel diagonal
+
+    // 1 image, or a directory / video for the pipeline
+    bool isDir = std::filesystem::is_directory(imgPath);
+    cv::Mat image = isDir ? cv::Mat() : cv::imread(imgPath, cv::IMREAD_GRAYSCALE);
+    bool pipeline = isDir || (image.empty() && cv::VideoCapture(imgPath).isOpened());
+    if (image.empty() && !pipeline) {
         std::cerr << "Error: Could not load image." << std::endl;
         return -1;
     }
+    if (!image.isContinuous())
+        image = image.clone();
     int width = image.cols;
     int height = image.rows;
-    std::vector<float> imageData(width * height);
-    std::vector<float> result(width * height, 0);
-
-    // Convert image to float
-    for (int i = 0; i < height; i++)
-        for (int j = 0; j < width; j++)
-            imageData[i * width + j] = image.at<uchar>(i, j) / 255.0f;
-
-    // OpenCL setup
-    cl_platform_id platform;
-    cl_device_id device;
-    cl_context context;
-    cl_command_queue queue;
-    cl_program program;
-    cl_kernel kernel;
-    cl_mem imageBuffer, resultBuffer;
-
-    CHECK_ERR(clGetPlatformIDs(1, &platform, NULL));
-    CHECK_ERR(clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &device, NULL));
-
-    context = clCreateContext(NULL, 1, &device, NULL, NULL, NULL);
-    queue = clCreateCommandQueueWithProperties(context, device, 0, NULL);
-
-    program = clCreateProgramWithSource(context, 1, &kernelSource, NULL, NULL);
-    CHECK_ERR(clBuildProgram(program, 0, NULL, NULL, NULL, NULL));
-
-    kernel = clCreateKernel(program, "computeZernike", NULL);
-
-    imageBuffer = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
-        width * height * sizeof(float), imageData.data(), NULL);
-    resultBuffer = clCreateBuffer(context, CL_MEM_WRITE_ONLY,
-        width * height * sizeof(float), NULL, NULL);
-
-    CHECK_ERR(clSetKernelArg(kernel, 0, sizeof(cl_mem), &imageBuffer));
-    CHECK_ERR(clSetKernelArg(kernel, 1, sizeof(cl_mem), &resultBuffer));
-    CHECK_ERR(clSetKernelArg(kernel, 2, sizeof(int), &width));
-    CHECK_ERR(clSetKernelArg(kernel, 3, sizeof(int), &height));
-    int order = 4;
-    CHECK_ERR(clSetKernelArg(kernel, 4, sizeof(int), &order));
+    cv::Mat edgeImage(height, width, CV_8UC1);
+
+    if (mode == "multi" && !pipeline) {
+        ZernikeMulti multi(order, N, kThr, lThr);
+        multi.run(image.data, edgeImage.data, width, height); // warm-up
+        double t = multi.run(image.data, edgeImage.data, width, height);
+        for (size_t k = 0; k < multi.devices(); k++)
+            std::cout << "  " << multi.device(k).name() << ": rows " << multi.strips()[k] << " - " << multi.strips()[k + 1] << std::endl;
+        std::cout << multi.devices() << " device(s): " << t * 1e3 << " ms, " << (double)width * height / t * 1e-6 << " MP/s" << std::endl;
+        cv::imwrite("output.jpg", edgeImage);
+        return 0;
+    }
+
+    // OpenCL setup: device by policy, context, queues & pool from the shared runtime.
+    // Program, masks & LUT and kernels: zernikeKernels.hpp.
+    // Everything below is owned by RAII wrappers, so early returns & errors leak nothing
+    ClRuntime& rt = ClRuntime::get();
+    cl_command_queue queue = rt.queue()();
+    cl_int err;
+
+    ZernikeKernels zk = zernikeKernels(rt, order, N, kThr, lThr);
+    printCacheStat(zk.build);
+    bool imageSupport = zk.imageSupport;
+    if (mode == "image" && !imageSupport) {
+        std::cerr << "Device has no image support, using tiled." << std::endl;
+        mode = "tiled";
+    }
+    size_t tx = zk.tx, ty = zk.ty;
+    size_t localSize[] = { tx, ty };
+
+    if (pipeline) {
+        int k = mode == "flat" ? 0 : 1; // buffer kernels only
+        runPipeline(imgPath, outDir, rt, zk.kernels[k](), k == 0 ? NULL : localSize);
+        return 0;
+    }
+
+    // Zero-copy: the device works on the cv::Mat pixels directly (uchar in, uchar out), no host conversion
+    cl::Buffer imageBuf(rt.context(), CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, width * height, image.data, &err);
+    CHECK_ERR(err);
+    cl::Buffer resultBuf(rt.context(), CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, width * height, edgeImage.data, &err);
+    CHECK_ERR(err);
+    cl_mem imageBuffer = imageBuf(), resultBuffer = resultBuf();
+    cl::Image2D image2d;
+    if (imageSupport) {
+        image2d = cl::Image2D(rt.context(), CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, cl::ImageFormat(CL_R, CL_UNORM_INT8),
+                              width, height, image.step, image.data, &err);
+        CHECK_ERR(err);
+    }
+    cl_mem image2dMem = image2d();
+    for (int k = 0; k < zk.count(); k++) {
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 0, sizeof(cl_mem), k == 2 ? &image2dMem : &imageBuffer));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 1, sizeof(cl_mem), &resultBuffer));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 2, sizeof(int), &width));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 3, sizeof(int), &height));
+    }
 
+    // Image sizes need not be multiples of the tile: round the NDRange up
     size_t globalSize[] = { static_cast<size_t>(width), static_cast<size_t>(height) };
-    CHECK_ERR(clEnqueueNDRangeKernel(queue, kernel, 2, NULL, globalSize, NULL, 0, NULL, NULL));
+    size_t tiledGlobal[] = { (width + tx - 1) / tx * tx, (height + ty - 1) / ty * ty };
 
-    CHECK_ERR(clEnqueueReadBuffer(queue, resultBuffer, CL_TRUE, 0, width * height * sizeof(float),
-        result.data(), 0, NULL, NULL));
+    if (mode == "points") {
+        ZernikePointList list(rt, zk);
+        list.run(imageBuffer, width, height); // warm-up: build & pool buffers
+        size_t readBytes = 0;
+        auto t0 = Clock::now();
+        std::vector<ZernikePoint> pts = list.run(imageBuffer, width, height, &readBytes);
+        double tPoints = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
 
-    // Convert result to an image
-    cv::Mat edgeImage(height, width, CV_8UC1);
-    for (int i = 0; i < height; i++)
-        for (int j = 0; j < width; j++)
-            edgeImage.at<uchar>(i, j) = static_cast<uchar>(result[i * width + j] * 255);
+        std::vector<uchar> dense(width * height);
+        t0 = Clock::now();
+        CHECK_ERR(clEnqueueNDRangeKernel(queue, zk.kernels[1](), 2, NULL, tiledGlobal, localSize, 0, NULL, NULL));
+        CHECK_ERR(clEnqueueReadBuffer(queue, resultBuffer, CL_TRUE, 0, width * height, dense.data(), 0, NULL, NULL));
+        double tDense = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
 
-    cv::imwrite("output.jpg", edgeImage);
+        // Every point must be an edge pixel of the dense map
+        size_t edgePixels = 0, outside = 0;
+        for (uchar e : dense)
+            edgePixels += e > 0;
+        edgeImage.setTo(0);
+        for (const ZernikePoint& p : pts) {
+            outside += dense[p.y * width + p.x] == 0;
+            edgeImage.at<uchar>(p.y, p.x) = cv::saturate_cast<uchar>(p.strength * 255.0f);
+        }
+        std::cout << "Dense:  " << tDense << " ms, " << width * height << " B read back, " << edgePixels << " edge pixels" << std::endl;
+        std::cout << "Points: " << tPoints << " ms, " << readBytes << " B read back, " << pts.size() << " points after NMS"
+                  << (outside ? ", " + std::to_string(outside) + " not in the dense map" : "") << std::endl;
+        cv::imwrite("output.jpg", edgeImage);
+        return outside != 0;
+    }
+
+    if (mode == "stack") {
+        std::vector<ZernikeMoment> mom = zernikeAllMoments(order);
+        std::vector<float> ref = zernikeMasks(mom, N);
+        size_t K = mom.size(), pixels = (size_t)width * height;
+        PooledBuffer stackBuf = rt.pool().acquire(pixels * K * 2 * sizeof(float), CL_MEM_WRITE_ONLY);
+        for (ZernikeLayout layout : { ZERNIKE_PLANAR, ZERNIKE_INTERLEAVED }) {
+            ZernikeStack zs(rt, mom, N, layout);
+            std::vector<float> basis = zs.basis();
+            float basisDiff = 0;
+            for (size_t i = 0; i < basis.size(); i++)
+                basisDiff = std::max(basisDiff, std::fabs(basis[i] - ref[i]));
+            zs.run(imageBuffer, stackBuf.get(), width, height); // warm-up
+            CHECK_ERR(clFinish(queue));
+            auto t0 = Clock::now();
+            zs.run(imageBuffer, stackBuf.get(), width, height);
+            CHECK_ERR(clFinish(queue));
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+            std::vector<float> stack(pixels * K * 2);
+            CHECK_ERR(clEnqueueReadBuffer(queue, stackBuf.get(), CL_TRUE, 0, stack.size() * sizeof(float), stack.data(), 0, NULL, NULL));
+
+            // Spot check: 1 pixel in 97, host convolution with the host masks
+            float stackDiff = 0;
+            for (size_t p = 0; p < pixels; p += 97) {
+                int x = p % width, y = p / width;
+                for (size_t k = 0; k < K; k++) {
+                    float re = 0, im = 0;
+                    for (int v = 0; v < N; v++)
+                        for (int u = 0; u < N; u++) {
+                            int xx = std::clamp(x + u - N / 2, 0, width - 1), yy = std::clamp(y + v - N / 2, 0, height - 1);
+                            float pixel = image.data[yy * width + xx] * (1.0f / 255.0f);
+                            re += pixel * ref[2 * ((k * N + v) * N + u)];
+                            im += pixel * ref[2 * ((k * N + v) * N + u) + 1];
+                        }
+                    size_t i = 2 * zs.index(k, p, pixels);
+                    stackDiff = std::max({ stackDiff, std::fabs(stack[i] - re), std::fabs(stack[i + 1] - im) });
+                }
+            }
+            std::cout << (layout == ZERNIKE_PLANAR ? "planar" : "interleaved") << ": " << K << " moments, " << ms << " ms, "
+                      << (double)pixels / ms * 1e-3 << " MP/s, max diff vs host: basis " << basisDiff << ", stack " << stackDiff
+                      << std::endl;
+        }
+        return 0;
+    }
 
-    // Cleanup
-    clReleaseMemObject(imageBuffer);
-    clReleaseMemObject(resultBuffer);
-    clReleaseKernel(kernel);
-    clReleaseProgram(program);
-    clReleaseCommandQueue(queue);
-    clReleaseContext(context);
+    if (mode == "bench") {
+        std::cout << "Tile " << tx << "x" << ty << ", " << width << "x" << height << ", order " << order << ", N " << N << std::endl;
+        std::vector<uchar> ref(width * height), out(width * height);
+        for (int k = 0; k < zk.count(); k++) {
+            double ns = k == 0 ? timeKernel(queue, zk.kernels[k](), globalSize, NULL, BENCH_REPS)
+                               : timeKernel(queue, zk.kernels[k](), tiledGlobal, localSize, BENCH_REPS);
+            CHECK_ERR(clEnqueueReadBuffer(queue, resultBuffer, CL_TRUE, 0, width * height,
+                k == 0 ? ref.data() : out.data(), 0, NULL, NULL));
+            int maxDiff = 0;
+            for (int i = 0; k > 0 && i < width * height; i++)
+                maxDiff = std::max(maxDiff, std::abs(out[i] - ref[i]));
+            std::cout << zernikeKernelNames[k] << ": " << ns * 1e-6 << " ms, " << (double)width * height / ns * 1e3 << " MP/s"
+                      << (k > 0 ? ", max diff vs flat " + std::to_string(maxDiff) : "") << std::endl;
+        }
+    }
+    else {
+        int k = mode == "flat" ? 0 : mode == "image" ? 2 : 1;
+        CHECK_ERR(clEnqueueNDRangeKernel(queue, zk.kernels[k](), 2, NULL, k == 0 ? globalSize : tiledGlobal,
+            k == 0 ? NULL : localSize, 0, NULL, NULL));
+    }
+
+    // Map to sync edgeImage with the device: no copy where host & device share memory
+    void* mapped = clEnqueueMapBuffer(queue, resultBuffer, CL_TRUE, CL_MAP_READ, 0, width * height, 0, NULL, NULL, &err);
+    CHECK_ERR(err);
+    CHECK_ERR(clEnqueueUnmapMemObject(queue, resultBuffer, mapped, 0, NULL, NULL));
+    CHECK_ERR(clFinish(queue));
+
+    cv::imwrite("output.jpg", edgeImage);
 
-    std::cout << "Edge detection complete. Output saved as output.jpg" << std::endl;
+    std::cout << "Edge detection complete (order " << order << ", " << N << "x" << N
+              << " window). Output saved as output.jpg" << std::endl;
     return 0;
 }
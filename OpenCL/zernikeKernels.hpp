@@ -0,0 +1,861 @@
+#pragma once
+#include <CL/cl.h>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include "zernikeMasks.hpp"
+#include "clRuntime.hpp"
+
+/*
+    Zernike edge kernels & their setup, shared by zernikeEdgeDetect.cpp and the benchmark suite
+    computeZernike:      1 global read per tap
+    computeZernikeTiled: TX x TY tile + (WIN - 1) halo in __local
+    computeZernikeImage: same via image2d_t (built with -D USE_IMAGE when the device has images)
+    All 3: uchar pixels in, uchar edge strength out, args 0..3 image, edges, width, height; 4..8 set by zernikeKernels().
+    computeZernikePoints: edge points instead of an image. Tiled, threshold + NMS + compaction on the device,
+                          args 0..3 image, points, width, height, 4..8 as above, 9 counter, 10 capacity.
+    zernikeHost: the same per-pixel computation on host threads (hetSched.hpp splits rows between both).
+    ZernikeStack: any (n, m) moment set per pixel in 1 pass, planar or interleaved stack (zernikeStackSource).
+    ZernikeStrip: a row range through the tiled kernel on 1 device, halo rows sent along.
+    ZernikeMulti: rows split over every device / sub-device of deviceSet(), 1 ZernikeStrip each.
+*/
+
+#define CHECK_ERR(x) if (x != CL_SUCCESS) { std::cerr << "OpenCL Error: " << x << std::endl; exit(1); }
+
+inline const char* const zernikeKernelSource = R"(
+// (k, l) least-squares fit of the step-edge model, returns edge strength k or 0, l in *lOut
+float zernikeFit(float2* Z, __constant float* lut, float kThr, float lThr, float zMin, float* lOut) {
+    *lOut = 0.0f;
+    float a = length(Z[0]); // |Z11|
+    if (a < zMin)
+        return 0.0f;
+
+    // rotate by the Z11 phase: Z'_n1 = Re(Z_n1 * conj(Z11)) / |Z11|
+    float2 rot = (float2)(Z[0].x, -Z[0].y) / a;
+    float z[NMOM];
+    float zz = 0.0f;
+    for (int k = 0; k < NMOM; k++) {
+        z[k] = (k < NM1) ? Z[k].x * rot.x - Z[k].y * rot.y : Z[k].x;
+        zz += z[k] * z[k];
+    }
+
+    float bestErr = INFINITY, bestDot = 0.0f, bestTT = 1.0f;
+    int best = 0;
+    for (int i = 0; i < NLUT; i++) {
+        __constant float* T = lut + i * (NMOM + 1);
+        float dot = 0.0f;
+        for (int k = 0; k < NMOM; k++)
+            dot += T[k] * z[k];
+        float err = zz - dot * dot / T[NMOM];
+        if (dot > 0.0f && err < bestErr) {
+            bestErr = err;
+            bestDot = dot;
+            bestTT = T[NMOM];
+            best = i;
+        }
+    }
+    float k = bestDot / bestTT;
+    float l = -1.0f + (best + 0.5f) * 2.0f / NLUT;
+    *lOut = l;
+    return (k >= kThr && fabs(l) <= lThr) ? k : 0.0f;
+}
+
+__kernel void computeZernike(__global const uchar* image, __global uchar* edgeOut, int width, int height,
+                             __constant float2* masks, __constant float* lut, float kThr, float lThr, float zMin) {
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x >= width || y >= height) return;
+
+    // Convolution with every mask, clamp-to-edge borders
+    float2 Z[NMOM];
+    for (int k = 0; k < NMOM; k++)
+        Z[k] = (float2)(0.0f, 0.0f);
+    for (int v = 0; v < WIN; v++) {
+        int yy = clamp(y + v - WIN / 2, 0, height - 1);
+        for (int u = 0; u < WIN; u++) {
+            int xx = clamp(x + u - WIN / 2, 0, width - 1);
+            float pixel = image[yy * width + xx] * (1.0f / 255.0f);
+            for (int k = 0; k < NMOM; k++)
+                Z[k] += pixel * masks[(k * WIN + v) * WIN + u];
+        }
+    }
+
+    float l;
+    edgeOut[y * width + x] = convert_uchar_sat(zernikeFit(Z, lut, kThr, lThr, zMin, &l) * 255.0f);
+}
+
+// Tiled: TX x TY work-group loads its tile + (WIN - 1) halo into __local once, then convolves from there.
+// Global size is rounded up to the tile: out-of-image work-items still help load & hit the barrier
+#define HW (TX + WIN - 1)
+#define HH (TY + WIN - 1)
+
+__kernel void computeZernikeTiled(__global const uchar* image, __global uchar* edgeOut, int width, int height,
+                                  __constant float2* masks, __constant float* lut, float kThr, float lThr, float zMin) {
+    __local float tile[HH * HW];
+    int lx = get_local_id(0);
+    int ly = get_local_id(1);
+    int x0 = get_group_id(0) * TX - WIN / 2;
+    int y0 = get_group_id(1) * TY - WIN / 2;
+
+    for (int i = ly * TX + lx; i < HH * HW; i += TX * TY) {
+        int xx = clamp(x0 + i % HW, 0, width - 1);
+        int yy = clamp(y0 + i / HW, 0, height - 1);
+        tile[i] = image[yy * width + xx] * (1.0f / 255.0f);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= width || y >= height) return;
+
+    float2 Z[NMOM];
+    for (int k = 0; k < NMOM; k++)
+        Z[k] = (float2)(0.0f, 0.0f);
+    for (int v = 0; v < WIN; v++) {
+        for (int u = 0; u < WIN; u++) {
+            float pixel = tile[(ly + v) * HW + lx + u];
+            for (int k = 0; k < NMOM; k++)
+                Z[k] += pixel * masks[(k * WIN + v) * WIN + u];
+        }
+    }
+
+    float l;
+    edgeOut[y * width + x] = convert_uchar_sat(zernikeFit(Z, lut, kThr, lThr, zMin, &l) * 255.0f);
+}
+
+#ifdef USE_IMAGE
+// Same, tile fetched through the sampler: clamp-to-edge & UNORM_INT8 -> [0, 1] done by the texture path
+__constant sampler_t smp = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+__kernel void computeZernikeImage(read_only image2d_t image, __global uchar* edgeOut, int width, int height,
+                                  __constant float2* masks, __constant float* lut, float kThr, float lThr, float zMin) {
+    __local float tile[HH * HW];
+    int lx = get_local_id(0);
+    int ly = get_local_id(1);
+    int x0 = get_group_id(0) * TX - WIN / 2;
+    int y0 = get_group_id(1) * TY - WIN / 2;
+
+    for (int i = ly * TX + lx; i < HH * HW; i += TX * TY)
+        tile[i] = read_imagef(image, smp, (int2)(x0 + i % HW, y0 + i / HW)).x;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= width || y >= height) return;
+
+    float2 Z[NMOM];
+    for (int k = 0; k < NMOM; k++)
+        Z[k] = (float2)(0.0f, 0.0f);
+    for (int v = 0; v < WIN; v++) {
+        for (int u = 0; u < WIN; u++) {
+            float pixel = tile[(ly + v) * HW + lx + u];
+            for (int k = 0; k < NMOM; k++)
+                Z[k] += pixel * masks[(k * WIN + v) * WIN + u];
+        }
+    }
+
+    float l;
+    edgeOut[y * width + x] = convert_uchar_sat(zernikeFit(Z, lut, kThr, lThr, zMin, &l) * 255.0f);
+}
+#endif
+
+// Edge points, on their own PX x PY tile (left out with -D NO_POINTS): the fits of the tile + a 1-pixel ring
+// (EX x EY) go to __local, so every pixel sees its neighbours. NMS along the gradient (Z11 phase, quantised to
+// 8 neighbours): k is ~flat across a step, so a pixel survives if the fitted edge passes closer to its centre
+// (|l|) than to either neighbour's.
+// Survivors: work-group scan of the flags, 1 atomic_add per group reserves its slots in the list.
+// count ends as the total even past capacity, the host grows the list & relaunches
+#ifndef NO_POINTS
+#define EX (PX + 2)
+#define EY (PY + 2)
+#define PW (EX + WIN - 1)
+#define PH (EY + WIN - 1)
+
+typedef struct {
+    int x, y;
+    float offset;   // sub-pixel: edge at (x, y) + offset * (cos angle, sin angle), pixels
+    float angle;    // gradient direction (dark to bright), radians, y down
+    float strength; // step height k, intensity in [0, 1]
+} ZernikePoint;
+
+__kernel void computeZernikePoints(__global const uchar* image, __global ZernikePoint* points, int width, int height,
+                                   __constant float2* masks, __constant float* lut, float kThr, float lThr, float zMin,
+                                   __global uint* count, uint capacity) {
+    __local float tile[PH * PW];
+    __local float fitK[EX * EY], fitL[EX * EY], fitA[EX * EY];
+    __local uint scan[PX * PY];
+    __local uint base;
+    int lx = get_local_id(0);
+    int ly = get_local_id(1);
+    int lid = ly * PX + lx;
+    int x0 = get_group_id(0) * PX - 1; // extended tile origin
+    int y0 = get_group_id(1) * PY - 1;
+
+    for (int i = lid; i < PH * PW; i += PX * PY) {
+        int xx = clamp(x0 - WIN / 2 + i % PW, 0, width - 1);
+        int yy = clamp(y0 - WIN / 2 + i / PW, 0, height - 1);
+        tile[i] = image[yy * width + xx] * (1.0f / 255.0f);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    for (int i = lid; i < EX * EY; i += PX * PY) {
+        int ex = i % EX, ey = i / EX;
+        float k = 0.0f, l = 0.0f, a = 0.0f;
+        if (x0 + ex >= 0 && x0 + ex < width && y0 + ey >= 0 && y0 + ey < height) {
+            float2 Z[NMOM];
+            for (int m = 0; m < NMOM; m++)
+                Z[m] = (float2)(0.0f, 0.0f);
+            for (int v = 0; v < WIN; v++) {
+                for (int u = 0; u < WIN; u++) {
+                    float pixel = tile[(ey + v) * PW + ex + u];
+                    for (int m = 0; m < NMOM; m++)
+                        Z[m] += pixel * masks[(m * WIN + v) * WIN + u];
+                }
+            }
+            k = zernikeFit(Z, lut, kThr, lThr, zMin, &l);
+            a = atan2(-Z[0].y, Z[0].x); // Z11 = |Z11| e^{-i angle}
+        }
+        fitK[i] = k;
+        fitL[i] = l;
+        fitA[i] = a;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int c = (ly + 1) * EX + lx + 1;
+    uint keep = 0;
+    if (x < width && y < height && fitK[c] > 0.0f) {
+        int dx = (int)rint(cos(fitA[c])), dy = (int)rint(sin(fitA[c]));
+        int f = c + dy * EX + dx, b = c - dy * EX - dx;
+        float d = fabs(fitL[c]);
+        keep = (fitK[f] == 0.0f || d < fabs(fitL[f])) && (fitK[b] == 0.0f || d <= fabs(fitL[b]));
+    }
+
+    // Inclusive scan (Hillis-Steele), last element = group total
+    scan[lid] = keep;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int off = 1; off < PX * PY; off *= 2) {
+        uint v = lid >= off ? scan[lid - off] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        scan[lid] += v;
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    if (lid == PX * PY - 1)
+        base = scan[lid] ? atomic_add(count, scan[lid]) : 0;
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    uint slot = base + scan[lid] - keep;
+    if (keep && slot < capacity) {
+        ZernikePoint p = { x, y, fitL[c] * (WIN / 2.0f), fitA[c], fitK[c] };
+        points[slot] = p;
+    }
+}
+#endif
+)";
+
+// __local bytes of a tx x ty work-group: tile + halo for the dense kernels (tiled, image, stack);
+// computeZernikePoints adds a 1-pixel ring, 3 fit arrays and the scan
+inline size_t zernikeLocalBytes(size_t tx, size_t ty, int N, bool points) {
+    if (points)
+        return ((tx + N + 1) * (ty + N + 1) + 3 * (tx + 2) * (ty + 2) + tx * ty + 1) * sizeof(float);
+    return (tx + N - 1) * (ty + N - 1) * sizeof(float);
+}
+
+// Work-group tile per device: tx x ty if given, else env ZERNIKE_WG="TXxTY", else by device type.
+// Halved down to the device limits (of the points kernel if points), 1 x 1 at worst. If even that does not
+// fit in local memory: exits for the dense kernels, returns false for the points kernel
+inline bool workGroupFor(cl_device_id device, int N, size_t& tx, size_t& ty, bool points = false) {
+    cl_device_type type;
+    size_t maxWg;
+    cl_ulong localMem;
+    CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_TYPE, sizeof(type), &type, NULL));
+    CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(maxWg), &maxWg, NULL));
+    CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_LOCAL_MEM_SIZE, sizeof(localMem), &localMem, NULL));
+
+    // CPU (e.g. POCL): wide rows vectorise along x. GPU: square tiles
+    if (tx == 0 || ty == 0) {
+        tx = (type & CL_DEVICE_TYPE_CPU) ? 64 : 16;
+        ty = (type & CL_DEVICE_TYPE_CPU) ? 4 : 16;
+        if (const char* env = getenv("ZERNIKE_WG")) {
+            size_t ex = 0, ey = 0;
+            if (sscanf(env, "%zux%zu", &ex, &ey) == 2 && ex >= 1 && ey >= 1 && ex <= maxWg && ey <= maxWg) {
+                tx = ex;
+                ty = ey;
+            } else {
+                std::cerr << "Warning: ZERNIKE_WG=" << env << " is not TXxTY with 1 <= TX, TY <= " << maxWg
+                          << ", using " << tx << "x" << ty << "." << std::endl;
+            }
+        }
+    }
+
+    while (tx * ty > maxWg || zernikeLocalBytes(tx, ty, N, points) > localMem) {
+        if (tx == 1 && ty == 1) {
+            if (points)
+                return false;
+            std::cerr << "Error: a " << N << "x" << N << " window does not fit in local memory (" << localMem
+                      << " B) even with a 1x1 work-group." << std::endl;
+            exit(1);
+        }
+        if (ty > 1) ty /= 2;
+        else tx /= 2;
+    }
+    return true;
+}
+
+// Kernel time (ns) of reps launches, after 1 warm-up
+inline double timeKernel(cl_command_queue queue, cl_kernel kernel, const size_t* global, const size_t* local, int reps) {
+    CHECK_ERR(clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, local, 0, NULL, NULL));
+    CHECK_ERR(clFinish(queue));
+    double total = 0;
+    for (int r = 0; r < reps; r++) {
+        cl_event ev;
+        CHECK_ERR(clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, local, 0, NULL, &ev));
+        CHECK_ERR(clWaitForEvents(1, &ev));
+        cl_ulong start, end;
+        CHECK_ERR(clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL));
+        CHECK_ERR(clGetEventProfilingInfo(ev, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL));
+        clReleaseEvent(ev);
+        total += end - start;
+    }
+    return total / reps;
+}
+
+// Built program, __constant masks & LUT and the kernels with args 4..8 set, for (order, N)
+struct ZernikeKernels {
+    std::vector<ZernikeMoment> mom;
+    std::vector<float> masks, lut; // host copies: zernikeHost
+    int N = 0, nm1 = 0;
+    float kThr = 0, lThr = 0, zMin = 0;
+    cl::Program program;
+    cl::Buffer maskBuf, lutBuf;
+    cl::Kernel kernels[3];    // flat, tiled, image
+    cl::Kernel points;        // computeZernikePoints, null if its tile does not fit in local memory
+    size_t tx = 0, ty = 0;    // tile of the tiled & image kernels
+    size_t px = 0, py = 0;    // tile of computeZernikePoints
+    bool imageSupport = false;
+    ClCacheStat build;
+
+    int count() const { return imageSupport ? 3 : 2; }
+};
+
+const char* const zernikeKernelNames[] = { "computeZernike", "computeZernikeTiled", "computeZernikeImage" };
+
+// Masks, LUT & thresholds for (order, N): everything zernikeHost needs, no device
+inline ZernikeKernels zernikeHostSetup(int order, int N, float kThr, float lThr) {
+    ZernikeKernels zk;
+    zk.mom = zernikeEdgeMoments(order);
+    zk.masks = zernikeMasks(zk.mom, N);
+    zk.lut = zernikeEdgeLut(zk.mom, zk.masks, N);
+    zk.nm1 = (order + 1) / 2;
+    // |Z11| below this cannot reach kThr for |l| <= lThr: skip the fit
+    float t11Min = INFINITY;
+    for (int i = 0; i < ZERNIKE_LUT; i++) {
+        float l = -1.0f + (i + 0.5f) * 2.0f / ZERNIKE_LUT;
+        if (std::fabs(l) <= lThr)
+            t11Min = std::min(t11Min, zk.lut[i * (zk.mom.size() + 1)]);
+    }
+    zk.zMin = 0.5f * kThr * (std::isinf(t11Min) ? 0.0f : t11Min);
+    zk.N = N;
+    zk.kThr = kThr;
+    zk.lThr = lThr;
+    return zk;
+}
+
+// tx x ty: work-group tile, 0 = workGroupFor's choice.
+// Rt: ClRuntime or anything with device(), context() & program(src, opts, stat) (ClDevice)
+template <typename Rt>
+ZernikeKernels zernikeKernels(Rt& rt, int order, int N, float kThr, float lThr, size_t tx = 0, size_t ty = 0) {
+    ZernikeKernels zk = zernikeHostSetup(order, N, kThr, lThr);
+    cl_device_id device = rt.device()();
+    cl_int err;
+    std::vector<float>& masks = zk.masks;
+    std::vector<float>& lut = zk.lut;
+    int nm1 = zk.nm1;
+    float zMin = zk.zMin;
+
+    cl_ulong constSize;
+    CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE, sizeof(constSize), &constSize, NULL));
+    if ((masks.size() + lut.size()) * sizeof(float) > constSize) {
+        std::cerr << "Error: masks + LUT exceed __constant memory (" << constSize << " B)." << std::endl;
+        exit(1);
+    }
+
+    cl_bool imageSupport;
+    CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_IMAGE_SUPPORT, sizeof(imageSupport), &imageSupport, NULL));
+    zk.imageSupport = imageSupport;
+    zk.tx = tx;
+    zk.ty = ty;
+    workGroupFor(device, N, zk.tx, zk.ty);
+    zk.px = zk.tx; // the points kernel needs more local memory: shrink further from the dense tile
+    zk.py = zk.ty;
+    bool points = workGroupFor(device, N, zk.px, zk.py, true);
+
+    std::string opts = "-D WIN=" + std::to_string(N) + " -D NMOM=" + std::to_string(zk.mom.size()) +
+                       " -D NM1=" + std::to_string(nm1) + " -D NLUT=" + std::to_string(ZERNIKE_LUT) +
+                       " -D TX=" + std::to_string(zk.tx) + " -D TY=" + std::to_string(zk.ty) +
+                       (points ? " -D PX=" + std::to_string(zk.px) + " -D PY=" + std::to_string(zk.py) : " -D NO_POINTS") +
+                       (imageSupport ? " -D USE_IMAGE" : "");
+    zk.program = rt.program(zernikeKernelSource, opts, &zk.build);
+
+    // __constant args: exact-size buffers, not pooled (a rounded-up size class could exceed constSize)
+    zk.maskBuf = cl::Buffer(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, masks.size() * sizeof(float), masks.data());
+    zk.lutBuf = cl::Buffer(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, lut.size() * sizeof(float), lut.data());
+    cl_mem maskBuffer = zk.maskBuf(), lutBuffer = zk.lutBuf();
+
+    // flat / tiled / image kernels share the argument list but for arg 0
+    for (int k = 0; k < zk.count(); k++) {
+        zk.kernels[k] = cl::Kernel(zk.program, zernikeKernelNames[k], &err);
+        CHECK_ERR(err);
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 4, sizeof(cl_mem), &maskBuffer));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 5, sizeof(cl_mem), &lutBuffer));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 6, sizeof(float), &kThr));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 7, sizeof(float), &lThr));
+        CHECK_ERR(clSetKernelArg(zk.kernels[k](), 8, sizeof(float), &zMin));
+    }
+    if (!points)
+        return zk;
+    zk.points = cl::Kernel(zk.program, "computeZernikePoints", &err);
+    CHECK_ERR(err);
+    CHECK_ERR(clSetKernelArg(zk.points(), 4, sizeof(cl_mem), &maskBuffer));
+    CHECK_ERR(clSetKernelArg(zk.points(), 5, sizeof(cl_mem), &lutBuffer));
+    CHECK_ERR(clSetKernelArg(zk.points(), 6, sizeof(float), &kThr));
+    CHECK_ERR(clSetKernelArg(zk.points(), 7, sizeof(float), &lThr));
+    CHECK_ERR(clSetKernelArg(zk.points(), 8, sizeof(float), &zMin));
+    return zk;
+}
+
+
+
+// ------ Host ------
+// computeZernike for rows [y0, y1) of out, OpenMP over rows. Same float math as the kernel:
+// results agree up to rounding of the last bit of k (1 grey level at most)
+inline void zernikeHost(const ZernikeKernels& zk, const unsigned char* image, unsigned char* out, int width, int height,
+                        int y0, int y1) {
+    const int N = zk.N, nmom = zk.mom.size(), nm1 = zk.nm1;
+    const float* masks = zk.masks.data(); // float2 per (k, v, u)
+    const float* lut = zk.lut.data();
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int y = y0; y < y1; y++) {
+        std::vector<float> Zr(nmom), Zi(nmom), z(nmom);
+        for (int x = 0; x < width; x++) {
+            std::fill(Zr.begin(), Zr.end(), 0.0f);
+            std::fill(Zi.begin(), Zi.end(), 0.0f);
+            for (int v = 0; v < N; v++) {
+                int yy = std::clamp(y + v - N / 2, 0, height - 1);
+                for (int u = 0; u < N; u++) {
+                    int xx = std::clamp(x + u - N / 2, 0, width - 1);
+                    float pixel = image[yy * width + xx] * (1.0f / 255.0f);
+                    for (int k = 0; k < nmom; k++) {
+                        const float* m = masks + 2 * ((k * N + v) * N + u);
+                        Zr[k] += pixel * m[0];
+                        Zi[k] += pixel * m[1];
+                    }
+                }
+            }
+
+            // zernikeFit
+            float e = 0.0f;
+            float a = std::sqrt(Zr[0] * Zr[0] + Zi[0] * Zi[0]);
+            if (a >= zk.zMin) {
+                float rx = Zr[0] / a, ry = -Zi[0] / a;
+                float zz = 0.0f;
+                for (int k = 0; k < nmom; k++) {
+                    z[k] = k < nm1 ? Zr[k] * rx - Zi[k] * ry : Zr[k];
+                    zz += z[k] * z[k];
+                }
+                float bestErr = INFINITY, bestDot = 0.0f, bestTT = 1.0f;
+                int best = 0;
+                for (int i = 0; i < ZERNIKE_LUT; i++) {
+                    const float* T = lut + i * (nmom + 1);
+                    float dot = 0.0f;
+                    for (int k = 0; k < nmom; k++)
+                        dot += T[k] * z[k];
+                    float err = zz - dot * dot / T[nmom];
+                    if (dot > 0.0f && err < bestErr) {
+                        bestErr = err;
+                        bestDot = dot;
+                        bestTT = T[nmom];
+                        best = i;
+                    }
+                }
+                float k = bestDot / bestTT;
+                float l = -1.0f + (best + 0.5f) * 2.0f / ZERNIKE_LUT;
+                e = (k >= zk.kThr && std::fabs(l) <= zk.lThr) ? k : 0.0f;
+            }
+            out[y * width + x] = (unsigned char)std::min(e * 255.0f, 255.0f); // convert_uchar_sat: toward 0
+        }
+    }
+}
+
+
+
+// ------ Row strips ------
+// Rows [lo, hi) of an image through the tiled kernel on 1 device: the strip goes up with N / 2 halo rows of its
+// neighbours on each side (clamped to the image), so clamp-to-edge only applies at the real image border and
+// strips join without seams. Buffers grow as needed and are kept between runs
+struct ZernikeStrip {
+    ZernikeKernels zk;
+    cl::Buffer in, out;
+    size_t capIn = 0, capOut = 0;
+
+    // Enqueued on q (in order); blocking: returns once rows [lo, hi) of edges are written, else after q.flush()
+    void run(const cl::Context& contxt, cl::CommandQueue& q, const unsigned char* image, unsigned char* edges,
+             int width, int height, int lo, int hi, bool blocking) {
+        int half = zk.N / 2;
+        int y0 = std::max(0, lo - half), y1 = std::min(height, hi + half), h = y1 - y0;
+        size_t bytes = (size_t)width * h;
+        reserveBuffer(contxt, in, capIn, bytes, CL_MEM_READ_ONLY);
+        reserveBuffer(contxt, out, capOut, bytes, CL_MEM_WRITE_ONLY);
+        q.enqueueWriteBuffer(in, CL_FALSE, 0, bytes, image + (size_t)y0 * width);
+        cl::Kernel& kern = zk.kernels[1]; // tiled
+        kern.setArg(0, in);
+        kern.setArg(1, out);
+        kern.setArg(2, width);
+        kern.setArg(3, h);
+        size_t tx = zk.tx, ty = zk.ty;
+        q.enqueueNDRangeKernel(kern, cl::NullRange, cl::NDRange((width + tx - 1) / tx * tx, (h + ty - 1) / ty * ty),
+                               cl::NDRange(tx, ty));
+        q.enqueueReadBuffer(out, blocking ? CL_TRUE : CL_FALSE, (size_t)(lo - y0) * width, (size_t)(hi - lo) * width,
+                            edges + (size_t)lo * width);
+        if (!blocking)
+            q.flush();
+    }
+};
+
+
+
+// ------ Multi-device ------
+// Rows cut into strips, 1 per device / sub-device (heights by compute units x clock), each unit with its own
+// context, queue, program & buffers (ZernikeStrip: halo rows sent along, no seams).
+// Every unit is enqueued without blocking, then all are waited for: they run concurrently
+class ZernikeMulti {
+public:
+    ZernikeMulti(int order, int N, float kThr, float lThr, const std::vector<cl::Device>& devs = deviceSet()) {
+        for (const cl::Device& d : devs) {
+            units_.emplace_back(d);
+            units_.back().strip.zk = zernikeKernels(units_.back().dev, order, N, kThr, lThr);
+        }
+    }
+
+    size_t devices() const { return units_.size(); }
+    const ClDevice& device(size_t k) const { return units_[k].dev; }
+    // Strip starts (rows) of the last run
+    const std::vector<size_t>& strips() const { return strip_; }
+
+    // out: width x height edges. Returns the wall time (s), transfers included
+    double run(const unsigned char* image, unsigned char* out, int width, int height) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> weight;
+        for (const Unit& u : units_)
+            weight.push_back(u.dev.weight());
+        strip_ = splitByWeight(height, weight);
+        for (size_t k = 0; k < units_.size(); k++) {
+            Unit& u = units_[k];
+            int lo = strip_[k], hi = strip_[k + 1];
+            if (lo == hi)
+                continue;
+            u.strip.run(u.dev.context(), u.dev.queue(), image, out, width, height, lo, hi, false);
+        }
+        for (Unit& u : units_)
+            u.dev.queue().finish();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    struct Unit {
+        explicit Unit(const cl::Device& d) : dev(d) {}
+        ClDevice dev;
+        ZernikeStrip strip;
+    };
+    std::deque<Unit> units_; // deque: ClDevice holds a mutex
+    std::vector<size_t> strip_;
+};
+
+
+
+// ------ Edge points ------
+// Host twin of the kernel's ZernikePoint
+struct ZernikePoint {
+    cl_int x, y;
+    cl_float offset, angle, strength;
+};
+
+// computeZernikePoints on 1 device image: the counter and count points come back instead of width x height
+// bytes. The list starts at width x height / 16 points; on overflow it grows to the count & the launch repeats.
+// Points sorted by (y, x): the atomic order varies from run to run
+class ZernikePointList {
+public:
+    ZernikePointList(ClRuntime& rt, ZernikeKernels& zk) : rt_(rt), zk_(zk) {}
+
+    // image: width x height uchar on the device. readBytes: D2H bytes of this call
+    std::vector<ZernikePoint> run(cl_mem image, int width, int height, size_t* readBytes = nullptr) {
+        if (!zk_.points()) {
+            std::cerr << "Error: computeZernikePoints does not fit in local memory for a " << zk_.N << "x" << zk_.N
+                      << " window, even with a 1x1 work-group." << std::endl;
+            exit(1);
+        }
+        cl_command_queue queue = rt_.queue()();
+        if (!count_.get())
+            count_ = rt_.pool().acquire(sizeof(cl_uint));
+        size_t want = std::max<size_t>(1024, (size_t)width * height / 16), read = 0;
+        size_t local[] = { zk_.px, zk_.py };
+        size_t global[] = { (width + zk_.px - 1) / zk_.px * zk_.px, (height + zk_.py - 1) / zk_.py * zk_.py };
+        cl_uint n = 0, zero = 0;
+        for (;;) {
+            if (want * sizeof(ZernikePoint) > list_.capacity())
+                list_ = rt_.pool().acquire(want * sizeof(ZernikePoint), CL_MEM_WRITE_ONLY);
+            cl_uint cap = list_.capacity() / sizeof(ZernikePoint);
+            cl_mem list = list_.get(), count = count_.get();
+            cl_kernel kernel = zk_.points();
+            CHECK_ERR(clEnqueueFillBuffer(queue, count, &zero, sizeof(zero), 0, sizeof(zero), 0, NULL, NULL));
+            CHECK_ERR(clSetKernelArg(kernel, 0, sizeof(cl_mem), &image));
+            CHECK_ERR(clSetKernelArg(kernel, 1, sizeof(cl_mem), &list));
+            CHECK_ERR(clSetKernelArg(kernel, 2, sizeof(int), &width));
+            CHECK_ERR(clSetKernelArg(kernel, 3, sizeof(int), &height));
+            CHECK_ERR(clSetKernelArg(kernel, 9, sizeof(cl_mem), &count));
+            CHECK_ERR(clSetKernelArg(kernel, 10, sizeof(cl_uint), &cap));
+            CHECK_ERR(clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, local, 0, NULL, NULL));
+            CHECK_ERR(clEnqueueReadBuffer(queue, count, CL_TRUE, 0, sizeof(n), &n, 0, NULL, NULL));
+            read += sizeof(n);
+            if (n <= cap)
+                break;
+            want = n;
+        }
+        std::vector<ZernikePoint> pts(n);
+        if (n)
+            CHECK_ERR(clEnqueueReadBuffer(queue, list_.get(), CL_TRUE, 0, n * sizeof(ZernikePoint), pts.data(), 0, NULL, NULL));
+        read += n * sizeof(ZernikePoint);
+        std::sort(pts.begin(), pts.end(), [](const ZernikePoint& a, const ZernikePoint& b) {
+            return a.y != b.y ? a.y < b.y : a.x < b.x;
+        });
+        if (readBytes)
+            *readBytes = read;
+        return pts;
+    }
+
+private:
+    ClRuntime& rt_;
+    ZernikeKernels& zk_;
+    PooledBuffer list_, count_;
+};
+
+
+// ------ Moment stack ------
+// Any set of (n, m) moments in 1 pass over the image, for feature extraction.
+// zernikeStackBasis: the masks of the set, built once on the device (1 work-item per tap, SUB x SUB sub-samples
+// like zernikeMasks()). Per sub-sample every R_nm, n <= NMAX, comes from Kintner's recurrence in n
+// (1 division by k1 per step, stable to order 12) and cos / sin(m theta) from the Chebyshev recurrence: no pow, sin or cos.
+// computeZernikeStack: tiled like computeZernikeTiled, all NSTACK moments from 1 tile load, written as
+// (re, im) float2 either planar (moment-major: plane k = width x height) or interleaved (-D INTERLEAVED,
+// pixel-major: the NSTACK moments of a pixel are contiguous)
+inline const char* const zernikeStackSource = R"(
+#define RIDX(n, m) ((n) * (NMAX + 1) + (m))
+
+__kernel void zernikeStackBasis(__constant int2* moms, __global float2* basis) {
+    int u = get_global_id(0);
+    int v = get_global_id(1);
+    if (u >= WIN || v >= WIN) return;
+
+    float2 acc[NSTACK];
+    for (int k = 0; k < NSTACK; k++)
+        acc[k] = (float2)(0.0f, 0.0f);
+    float R[(NMAX + 1) * (NMAX + 1)];
+    float cm[NMAX + 1], sm[NMAX + 1];
+    for (int sv = 0; sv < SUB; sv++) {
+        for (int su = 0; su < SUB; su++) {
+            float x = (2.0f * (u + (su + 0.5f) / SUB) - WIN) / WIN;
+            float y = (2.0f * (v + (sv + 0.5f) / SUB) - WIN) / WIN;
+            float r2 = x * x + y * y;
+            if (r2 > 1.0f)
+                continue;
+            float rho = sqrt(r2);
+
+            // R_mm = rho^m, R_m+2,m = (m + 2) rho^(m+2) - (m + 1) rho^m, then Kintner up to NMAX
+            float pm = 1.0f;
+            for (int m = 0; m <= NMAX; m++) {
+                R[RIDX(m, m)] = pm;
+                if (m + 2 <= NMAX)
+                    R[RIDX(m + 2, m)] = ((m + 2) * r2 - (m + 1)) * pm;
+                for (int n = m + 4; n <= NMAX; n += 2) {
+                    float k1 = (n + m) * (n - m) * (n - 2) / 2.0f;
+                    float k2 = 2.0f * n * (n - 1) * (n - 2);
+                    float k3 = -(float)(m * m * (n - 1)) - (float)(n * (n - 1) * (n - 2));
+                    float k4 = -(n * (n + m - 2) * (n - m - 2)) / 2.0f;
+                    R[RIDX(n, m)] = ((k2 * r2 + k3) * R[RIDX(n - 2, m)] + k4 * R[RIDX(n - 4, m)]) / k1;
+                }
+                pm *= rho;
+            }
+            // cos / sin(m theta): c_m = 2 c_1 c_m-1 - c_m-2 (same for s). rho = 0: only m = 0 is non-zero
+            cm[0] = 1.0f;
+            sm[0] = 0.0f;
+            cm[1] = rho > 0.0f ? x / rho : 1.0f;
+            sm[1] = rho > 0.0f ? y / rho : 0.0f;
+            for (int m = 2; m <= NMAX; m++) {
+                cm[m] = 2.0f * cm[1] * cm[m - 1] - cm[m - 2];
+                sm[m] = 2.0f * cm[1] * sm[m - 1] - sm[m - 2];
+            }
+            for (int k = 0; k < NSTACK; k++) {
+                int n = moms[k].x, m = moms[k].y;
+                acc[k] += R[RIDX(n, m)] * (float2)(cm[m], -sm[m]);
+            }
+        }
+    }
+    float dA = (2.0f / WIN) * (2.0f / WIN) / (SUB * SUB);
+    for (int k = 0; k < NSTACK; k++)
+        basis[(k * WIN + v) * WIN + u] = acc[k] * ((moms[k].x + 1) * M_1_PI_F * dA);
+}
+
+#define HW (TX + WIN - 1)
+#define HH (TY + WIN - 1)
+
+__kernel void computeZernikeStack(__global const uchar* image, __global float2* stack, int width, int height,
+                                  __constant float2* basis) {
+    __local float tile[HH * HW];
+    int lx = get_local_id(0);
+    int ly = get_local_id(1);
+    int x0 = get_group_id(0) * TX - WIN / 2;
+    int y0 = get_group_id(1) * TY - WIN / 2;
+
+    for (int i = ly * TX + lx; i < HH * HW; i += TX * TY) {
+        int xx = clamp(x0 + i % HW, 0, width - 1);
+        int yy = clamp(y0 + i / HW, 0, height - 1);
+        tile[i] = image[yy * width + xx] * (1.0f / 255.0f);
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= width || y >= height) return;
+
+    float2 Z[NSTACK];
+    for (int k = 0; k < NSTACK; k++)
+        Z[k] = (float2)(0.0f, 0.0f);
+    for (int v = 0; v < WIN; v++) {
+        for (int u = 0; u < WIN; u++) {
+            float pixel = tile[(ly + v) * HW + lx + u];
+            for (int k = 0; k < NSTACK; k++)
+                Z[k] += pixel * basis[(k * WIN + v) * WIN + u];
+        }
+    }
+
+    size_t p = (size_t)y * width + x;
+    for (int k = 0; k < NSTACK; k++) {
+#ifdef INTERLEAVED
+        stack[p * NSTACK + k] = Z[k];
+#else
+        stack[k * (size_t)width * height + p] = Z[k];
+#endif
+    }
+}
+)";
+
+enum ZernikeLayout { ZERNIKE_PLANAR, ZERNIKE_INTERLEAVED };
+
+// Moment stack of 1 image per run(): width x height x moments() (re, im) pairs in the chosen layout.
+// The basis is built on the device in the constructor, basis() reads it back (same layout as zernikeMasks())
+class ZernikeStack {
+public:
+    ZernikeStack(ClRuntime& rt, const std::vector<ZernikeMoment>& mom, int N, ZernikeLayout layout = ZERNIKE_PLANAR,
+                 size_t tx = 0, size_t ty = 0)
+        : rt_(rt), mom_(mom), N_(N), layout_(layout), tx_(tx), ty_(ty) {
+        int nmax = 0;
+        std::vector<cl_int> moms;
+        for (const ZernikeMoment& z : mom) {
+            if (z.n < 0 || z.m < 0 || z.m > z.n || (z.n - z.m) % 2 || z.n > 12) {
+                std::cerr << "Error: bad moment (" << z.n << ", " << z.m << "), need 0 <= m <= n <= 12, n - m even." << std::endl;
+                exit(1);
+            }
+            nmax = std::max(nmax, z.n);
+            moms.push_back(z.n);
+            moms.push_back(z.m);
+        }
+        cl_device_id device = rt.device()();
+        cl_ulong constSize;
+        CHECK_ERR(clGetDeviceInfo(device, CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE, sizeof(constSize), &constSize, NULL));
+        size_t basisBytes = mom.size() * N * N * 2 * sizeof(float);
+        if (mom.empty() || basisBytes > constSize) {
+            std::cerr << "Error: moment set empty or its basis exceeds __constant memory (" << constSize << " B)." << std::endl;
+            exit(1);
+        }
+        workGroupFor(device, N, tx_, ty_);
+
+        std::string opts = "-D WIN=" + std::to_string(N) + " -D NSTACK=" + std::to_string(mom.size()) +
+                           " -D NMAX=" + std::to_string(std::max(nmax, 1)) + " -D SUB=" + std::to_string(ZERNIKE_SUB) +
+                           " -D TX=" + std::to_string(tx_) + " -D TY=" + std::to_string(ty_) +
+                           (layout == ZERNIKE_INTERLEAVED ? " -D INTERLEAVED" : "");
+        program_ = rt.program(zernikeStackSource, opts, &build_);
+        cl_int err;
+        cl::Kernel basisKernel(program_, "zernikeStackBasis", &err);
+        CHECK_ERR(err);
+        stack_ = cl::Kernel(program_, "computeZernikeStack", &err);
+        CHECK_ERR(err);
+
+        // __constant args: exact-size buffers, not pooled (as zernikeKernels)
+        momBuf_ = cl::Buffer(rt.context(), CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, moms.size() * sizeof(cl_int), moms.data());
+        basisBuf_ = cl::Buffer(rt.context(), CL_MEM_READ_WRITE, basisBytes);
+        cl_mem momBuffer = momBuf_(), basisBuffer = basisBuf_();
+        CHECK_ERR(clSetKernelArg(basisKernel(), 0, sizeof(cl_mem), &momBuffer));
+        CHECK_ERR(clSetKernelArg(basisKernel(), 1, sizeof(cl_mem), &basisBuffer));
+        size_t global[] = { (size_t)N, (size_t)N };
+        CHECK_ERR(clEnqueueNDRangeKernel(rt.queue()(), basisKernel(), 2, NULL, global, NULL, 0, NULL, NULL));
+        CHECK_ERR(clSetKernelArg(stack_(), 4, sizeof(cl_mem), &basisBuffer));
+    }
+
+    size_t moments() const { return mom_.size(); }
+    ZernikeLayout layout() const { return layout_; }
+    const ClCacheStat& build() const { return build_; }
+
+    // Element (moment k, pixel p) of a stack: (re, im) at 2 * index
+    size_t index(size_t k, size_t p, size_t pixels) const {
+        return layout_ == ZERNIKE_INTERLEAVED ? p * mom_.size() + k : k * pixels + p;
+    }
+
+    std::vector<float> basis() const {
+        std::vector<float> b(mom_.size() * N_ * N_ * 2);
+        CHECK_ERR(clEnqueueReadBuffer(rt_.queue()(), basisBuf_(), CL_TRUE, 0, b.size() * sizeof(float), b.data(), 0, NULL, NULL));
+        return b;
+    }
+
+    // Device in & out: image width x height uchar, stack width x height x moments() float2
+    void run(cl_mem image, cl_mem stack, int width, int height) {
+        CHECK_ERR(clSetKernelArg(stack_(), 0, sizeof(cl_mem), &image));
+        CHECK_ERR(clSetKernelArg(stack_(), 1, sizeof(cl_mem), &stack));
+        CHECK_ERR(clSetKernelArg(stack_(), 2, sizeof(int), &width));
+        CHECK_ERR(clSetKernelArg(stack_(), 3, sizeof(int), &height));
+        size_t global[] = { (width + tx_ - 1) / tx_ * tx_, (height + ty_ - 1) / ty_ * ty_ };
+        size_t local[] = { tx_, ty_ };
+        CHECK_ERR(clEnqueueNDRangeKernel(rt_.queue()(), stack_(), 2, NULL, global, local, 0, NULL, NULL));
+    }
+
+    // Host in & out through pooled buffers
+    std::vector<float> run(const unsigned char* image, int width, int height) {
+        size_t pixels = (size_t)width * height, bytes = pixels * mom_.size() * 2 * sizeof(float);
+        PooledBuffer in = rt_.pool().acquire(pixels, CL_MEM_READ_ONLY);
+        PooledBuffer out = rt_.pool().acquire(bytes, CL_MEM_WRITE_ONLY);
+        std::vector<float> stack(pixels * mom_.size() * 2);
+        cl_command_queue queue = rt_.queue()();
+        CHECK_ERR(clEnqueueWriteBuffer(queue, in.get(), CL_FALSE, 0, pixels, image, 0, NULL, NULL));
+        run(in.get(), out.get(), width, height);
+        CHECK_ERR(clEnqueueReadBuffer(queue, out.get(), CL_TRUE, 0, bytes, stack.data(), 0, NULL, NULL));
+        return stack;
+    }
+
+private:
+    ClRuntime& rt_;
+    std::vector<ZernikeMoment> mom_;
+    int N_;
+    ZernikeLayout layout_;
+    size_t tx_, ty_;
+    cl::Program program_;
+    cl::Kernel stack_;
+    cl::Buffer momBuf_, basisBuf_;
+    ClCacheStat build_;
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cmath>
+
+/*
+    Zernike moment masks for an N x N window (Ghosal-Mehrotra)
+    The window is mapped onto the unit disk, mask (n, m) at pixel (u, v) = (n+1)/pi * integral over the
+    pixel's part of the disk of V*_nm = R_nm(rho) e^{-i m theta}  (S x S sub-samples per pixel).
+    Moment of a window: Z_nm = sum f(u, v) * mask_nm(u, v), i.e. a convolution: no per-pixel trig.
+
+    Edge model: step of height k at signed distance l from the window centre (unit-disk units).
+    After rotating by the Z11 phase, Z'_n1 & Z_n0 depend on (k, l) only: Z = k * T(l).
+    T(l) is tabulated on host with the same masks, so the kernel fits (k, l) by least squares
+    over every m = 0 / m = 1 moment up to `order`.
+*/
+
+#define ZERNIKE_SUB 16   // sub-samples per pixel edge
+#define ZERNIKE_LUT 128  // l samples over (-1, 1)
+#define ZERNIKE_PI 3.14159265358979323846
+
+struct ZernikeMoment {
+    int n, m;
+};
+
+inline double factorial(int k) {
+    double f = 1;
+    for (int i = 2; i <= k; i++)
+        f *= i;
+    return f;
+}
+
+// R_nm(rho) = sum_s (-1)^s (n-s)! / (s! ((n+m)/2-s)! ((n-m)/2-s)!) rho^(n-2s)
+inline double zernikeRadial(int n, int m, double rho) {
+    double r = 0;
+    for (int s = 0; s <= (n - m) / 2; s++) {
+        double c = factorial(n - s) / (factorial(s) * factorial((n + m) / 2 - s) * factorial((n - m) / 2 - s));
+        r += (s % 2 ? -c : c) * std::pow(rho, n - 2 * s);
+    }
+    return r;
+}
+
+// Moments used by the edge fit: (n, 1) for odd n, then (n, 0) for even n >= 2. (1, 1) comes first
+inline std::vector<ZernikeMoment> zernikeEdgeMoments(int order) {
+    std::vector<ZernikeMoment> mom;
+    for (int n = 1; n <= order; n += 2)
+        mom.push_back({ n, 1 });
+    for (int n = 2; n <= order; n += 2)
+        mom.push_back({ n, 0 });
+    return mom;
+}
+
+// All (n, m), m >= 0, n - m even, n <= order
+inline std::vector<ZernikeMoment> zernikeAllMoments(int order) {
+    std::vector<ZernikeMoment> mom;
+    for (int n = 0; n <= order; n++)
+        for (int m = n % 2; m <= n; m += 2)
+            mom.push_back({ n, m });
+    return mom;
+}
+
+// Masks: [moment][v * N + u] as (re, im) pairs
+inline std::vector<float> zernikeMasks(const std::vector<ZernikeMoment>& mom, int N) {
+    std::vector<float> masks(mom.size() * N * N * 2, 0.0f);
+    double dA = (2.0 / N) * (2.0 / N) / (ZERNIKE_SUB * ZERNIKE_SUB);
+    for (size_t k = 0; k < mom.size(); k++) {
+        int n = mom[k].n, m = mom[k].m;
+        for (int v = 0; v < N; v++) {
+            for (int u = 0; u < N; u++) {
+                double re = 0, im = 0;
+                for (int sv = 0; sv < ZERNIKE_SUB; sv++) {
+                    for (int su = 0; su < ZERNIKE_SUB; su++) {
+                        double x = (2.0 * (u + (su + 0.5) / ZERNIKE_SUB) - N) / N;
+                        double y = (2.0 * (v + (sv + 0.5) / ZERNIKE_SUB) - N) / N;
+                        double rho = std::sqrt(x * x + y * y);
+                        if (rho > 1.0)
+                            continue;
+                        double r = zernikeRadial(n, m, rho);
+                        double th = std::atan2(y, x);
+                        re += r * std::cos(m * th);
+                        im -= r * std::sin(m * th);
+                    }
+                }
+                double s = (n + 1) / ZERNIKE_PI * dA;
+                masks[(k * N * N + v * N + u) * 2] = (float)(re * s);
+                masks[(k * N * N + v * N + u) * 2 + 1] = (float)(im * s);
+            }
+        }
+    }
+    return masks;
+}
+
+// Edge LUT: row i = l_i = -1 + (i + 0.5) * 2 / ZERNIKE_LUT, columns T_0..T_{K-1}, then sum T^2
+inline std::vector<float> zernikeEdgeLut(const std::vector<ZernikeMoment>& mom, const std::vector<float>& masks, int N) {
+    size_t K = mom.size();
+    std::vector<float> lut(ZERNIKE_LUT * (K + 1));
+    std::vector<double> cover(N * N);
+    for (int i = 0; i < ZERNIKE_LUT; i++) {
+        double l = -1.0 + (i + 0.5) * 2.0 / ZERNIKE_LUT;
+        // unit step over x > l, area fraction per pixel
+        for (int v = 0; v < N; v++) {
+            for (int u = 0; u < N; u++) {
+                int in = 0;
+                for (int su = 0; su < ZERNIKE_SUB; su++) {
+                    double x = (2.0 * (u + (su + 0.5) / ZERNIKE_SUB) - N) / N;
+                    in += x > l;
+                }
+                cover[v * N + u] = (double)in / ZERNIKE_SUB;
+            }
+        }
+        double tt = 0;
+        for (size_t k = 0; k < K; k++) {
+            double z = 0;
+            for (int p = 0; p < N * N; p++)
+                z += cover[p] * masks[(k * N * N + p) * 2]; // step along x: imaginary parts cancel
+            lut[i * (K + 1) + k] = (float)z;
+            tt += z * z;
+        }
+        lut[i * (K + 1) + K] = (float)tt;
+    }
+    return lut;
+}
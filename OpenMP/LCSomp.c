@@ -0,0 +1,203 @@
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N 20000 // default sequence length w/o input files
+#define BS 256  // block edge: BS x BS ints = 256 KB, ~L2
+
+/*
+    Tiled LCS w/ OpenMP tasks
+    Table: 1 contiguous row-major (m+1) x (n+1) array.
+    Block (bi, bj) depends on (bi-1, bj), (bi, bj-1), (bi-1, bj-1);
+    `depend` on 1 sentinel byte per block lets the runtime run every ready block, no global barrier per diagonal.
+*/
+
+static void lcsBlock(const char* a, const char* b, int n, int* tab, int i0, int i1, int j0, int j1) {
+    for (int i = i0; i < i1; i++) {
+        int* row = tab + (size_t)i * (n + 1);
+        const int* up = row - (n + 1);
+        char ai = a[i - 1];
+        for (int j = j0; j < j1; j++) {
+            if (ai == b[j - 1])
+                row[j] = up[j - 1] + 1;
+            else
+                row[j] = row[j - 1] > up[j] ? row[j - 1] : up[j];
+        }
+    }
+}
+
+// Fills tab (row 0 & column 0 already 0)
+static void lcsTiled(const char* a, const char* b, int m, int n, int* tab, int bs) {
+    int nbi = (m + bs - 1) / bs;
+    int nbj = (n + bs - 1) / bs;
+    // padded by 1 row/column so block (0, *) and (*, 0) can name their missing neighbours
+    char* dep = calloc((size_t)(nbi + 1) * (nbj + 1), 1);
+    if (!dep) {
+        printf("Dependency grid of %d x %d blocks does not fit in memory\n", nbi + 1, nbj + 1);
+        exit(1);
+    }
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        for (int bi = 1; bi <= nbi; bi++) {
+            for (int bj = 1; bj <= nbj; bj++) {
+                // in: top, left, diag / out: self
+                #pragma omp task firstprivate(bi, bj) \
+                    depend(in: dep[(bi - 1) * (nbj + 1) + bj], dep[bi * (nbj + 1) + bj - 1], dep[(bi - 1) * (nbj + 1) + bj - 1]) \
+                    depend(out: dep[bi * (nbj + 1) + bj])
+                {
+                    int i0 = (bi - 1) * bs + 1;
+                    int j0 = (bj - 1) * bs + 1;
+                    int i1 = i0 + bs > m + 1 ? m + 1 : i0 + bs;
+                    int j1 = j0 + bs > n + 1 ? n + 1 : j0 + bs;
+                    lcsBlock(a, b, n, tab, i0, i1, j0, j1);
+                }
+            }
+        }
+    }
+    free(dep);
+}
+
+// Table traversal from the very last elem, returns malloc'd string
+static char* lcsSeq(const char* a, const char* b, int m, int n, const int* tab) {
+    int len = tab[(size_t)m * (n + 1) + n];
+    char* seq = malloc(len + 1);
+    if (!seq) {
+        printf("LCS of length %d does not fit in memory\n", len);
+        exit(1);
+    }
+    seq[len] = '\0';
+    int r = m, c = n;
+    while (r != 0 && c != 0) {
+        size_t idx = (size_t)r * (n + 1) + c;
+        if (a[r - 1] == b[c - 1]) {
+            seq[--len] = a[r - 1];
+            r--;
+            c--;
+        }
+        else if (tab[idx - (n + 1)] >= tab[idx - 1])
+            r--;
+        else
+            c--;
+    }
+    return seq;
+}
+
+static char* readSeq(const char* path, int* len) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        printf("Cannot open %s\n", path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    if (sz < 0) {
+        printf("Cannot size %s\n", path);
+        exit(1);
+    }
+    fseek(f, 0, SEEK_SET);
+    char* s = malloc(sz + 1);
+    if (!s) {
+        printf("%s (%ld bytes) does not fit in memory\n", path, sz);
+        exit(1);
+    }
+    *len = 0;
+    for (long i = 0; i < sz; i++) {
+        int ch = fgetc(f);
+        if (ch != '\n' && ch != '\r')
+            s[(*len)++] = ch;
+    }
+    s[*len] = '\0';
+    fclose(f);
+    return s;
+}
+
+int main(int argc, char** argv) {
+    double start, end, t, t1 = 0;
+    int m, n;
+    char *A, *B;
+
+    int bs = BS;
+    if (argc >= 4) {
+        char* end;
+        long v = strtol(argv[3], &end, 10);
+        if (end == argv[3] || *end != '\0' || v < 1 || v > 1 << 20) {
+            printf("Usage: %s [fileA fileB [block]], 1 <= block <= 2^20\n", argv[0]);
+            return 1;
+        }
+        bs = (int)v;
+    }
+
+    // ------ Input: 2 files or random ACGT of length N ------
+    if (argc >= 3) {
+        A = readSeq(argv[1], &m);
+        B = readSeq(argv[2], &n);
+    }
+    else {
+        m = n = N;
+        A = malloc(m + 1);
+        B = malloc(n + 1);
+        if (!A || !B) {
+            printf("2 sequences of %d do not fit in memory\n", N);
+            return 1;
+        }
+        srand(1);
+        for (int i = 0; i < m; i++) A[i] = "ACGT"[rand() % 4];
+        for (int i = 0; i < n; i++) B[i] = "ACGT"[rand() % 4];
+        A[m] = B[n] = '\0';
+    }
+
+    int* tab = calloc((size_t)(m + 1) * (n + 1), sizeof(int));
+    if (!tab) {
+        printf("Table of %d x %d does not fit in memory\n", m + 1, n + 1);
+        return 1;
+    }
+
+    memset(tab, 0, (size_t)(m + 1) * (n + 1) * sizeof(int)); // fault pages in before timing
+
+    // Sequential reference
+    start = omp_get_wtime();
+    lcsBlock(A, B, n, tab, 1, m + 1, 1, n + 1);
+    end = omp_get_wtime();
+    int ref = tab[(size_t)m * (n + 1) + n];
+    printf("m = %d, n = %d, block = %d\n", m, n, bs);
+    printf("Sequential Execution time: %f seconds, LCS length %d\n", end - start, ref);
+
+    // ------ Thread-count scaling ------
+    int maxTh = omp_get_max_threads();
+    printf("%8s %12s %10s %10s %8s\n", "threads", "time (s)", "speedup", "effic.", "GCUPS");
+    for (int th = 1; th <= maxTh; th = (th * 2 > maxTh && th != maxTh) ? maxTh : th * 2) {
+        memset(tab, 0, (size_t)(m + 1) * (n + 1) * sizeof(int));
+        omp_set_num_threads(th);
+
+        start = omp_get_wtime();
+        lcsTiled(A, B, m, n, tab, bs);
+        end = omp_get_wtime();
+        t = end - start;
+        if (th == 1)
+            t1 = t;
+
+        if (tab[(size_t)m * (n + 1) + n] != ref) {
+            printf("Mismatch at %d threads: %d != %d\n", th, tab[(size_t)m * (n + 1) + n], ref);
+            return 1;
+        }
+        printf("%8d %12f %10.2f %10.2f %8.3f\n", th, t, t1 / t, t1 / t / th, (double)m * n / t * 1e-9);
+    }
+
+    char* seq = lcsSeq(A, B, m, n, tab);
+    if (strlen(seq) <= 100)
+        printf("The LCS: %s\n", seq);
+
+    free(seq);
+    free(tab);
+    free(A);
+    free(B);
+    return 0;
+}
+
+/* Compile
+    gcc -O2 -fopenmp LCSomp.c -o LCSomp.exe
+    ./LCSomp.exe [fileA fileB [block]]
+*/
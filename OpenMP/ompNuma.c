@@ -0,0 +1,92 @@
+#include "ompNuma.h" // first: defines _GNU_SOURCE
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_DEF (1LL << 27) // doubles per array: 1 GB
+#define REPS 5
+
+/*
+    NUMA report & first-touch effect (ompNuma.h)
+    ./ompNuma [MB per array]     OMP_NUMA=spread|close|off
+    1. topology, binding & where each thread runs
+    2. node x node read bandwidth (diagonal: per socket, local)
+    3. triad a = b + 3c: arrays initialised by 1 thread (all pages on its node) vs first touch
+       with the loop's own schedule. Same numbers on a single node.
+*/
+
+static double triad(double* a, const double* b, const double* c, long long n) {
+    double best = 1e30;
+    for (int r = 0; r < REPS; r++) {
+        double start = omp_get_wtime();
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < n; i++)
+            a[i] = b[i] + 3.0 * c[i];
+        double t = omp_get_wtime() - start;
+        best = t < best ? t : best;
+    }
+    return 3.0 * n * sizeof(double) / best * 1e-9;
+}
+
+int main(int argc, char** argv) {
+    long long n = N_DEF;
+    if (argc > 1) {
+        char* end;
+        long long mb = strtoll(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0' || mb < 1) {
+            printf("Usage: %s [MB per array], MB >= 1\n", argv[0]);
+            return 1;
+        }
+        n = mb * (1 << 20) / (long long)sizeof(double);
+    }
+    OmpTopo topo;
+    ompTopo(&topo);
+    int policy = ompNumaSetup(&topo, ompNumaPolicy());
+    ompNumaReport(&topo, policy);
+    printf("\n");
+    ompNumaBandwidth(&topo, n * sizeof(double));
+    printf("\n");
+
+    // 1 thread writes everything: every page on its node
+    double* a = aligned_alloc(OMP_NUMA_PAGE, n * sizeof(double));
+    double* b = aligned_alloc(OMP_NUMA_PAGE, n * sizeof(double));
+    double* c = aligned_alloc(OMP_NUMA_PAGE, n * sizeof(double));
+    if (!a || !b || !c) {
+        printf(" Cannot allocate 3 x %lld doubles.\n", n);
+        return 1;
+    }
+    memset(a, 0, n * sizeof(double));
+    for (long long i = 0; i < n; i++) {
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    printf("Triad, serial init: %8.2f GB/s\n", triad(a, b, c, n));
+    free(a);
+    free(b);
+    free(c);
+
+    // First touch: the pages of thread t's range on thread t's node
+    a = ompNumaAlloc(n, sizeof(double));
+    b = ompNumaAlloc(n, sizeof(double));
+    c = ompNumaAlloc(n, sizeof(double));
+    if (!a || !b || !c) {
+        printf(" Cannot allocate 3 x %lld doubles.\n", n);
+        return 1;
+    }
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < n; i++) {
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    printf("Triad, first touch: %8.2f GB/s\n", triad(a, b, c, n));
+    int bad = a[n - 1] != 7.0;
+    free(a);
+    free(b);
+    free(c);
+    return bad;
+}
+
+/* Compile
+    gcc -O2 -fopenmp <file>.c -o <file>.exe
+*/
@@ -0,0 +1,335 @@
+#ifndef OMP_NUMA_H
+#define OMP_NUMA_H
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // sched_setaffinity, sched_getcpu: include this header before any system header
+#endif
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+/*
+    NUMA-aware placement for the OpenMP kernels, no libnuma needed
+    - ompTopo: nodes & their cpus from /sys/devices/system/node; 1 node with every cpu if that is missing
+      (not Linux, container w/o sysfs, single socket), where everything below turns into a no-op.
+    - Pinning: OMP_NUMA=spread (default) | close | off. spread: thread t on node t % nodes,
+      close: consecutive threads share a node. Each thread gets all cpus of its node, not 1 core.
+      Left to the runtime (off) when OMP_PLACES or OMP_PROC_BIND is set.
+    - First touch: Linux puts a page on the node of the thread that writes it first, so arrays are
+      zeroed with the same schedule(static) split as the loops that use them (ompNumaAlloc).
+    - OmpArena: bump allocator per node, for buffers whose user is known by node, not by index range.
+    - Report (topology, binding, thread -> cpu) & node x node read bandwidth.
+*/
+
+#define OMP_NUMA_MAX_NODES 64
+#define OMP_NUMA_MAX_CPUS 1024
+#define OMP_NUMA_PAGE 4096
+#define OMP_NUMA_ALIGN 64  // arena allocations: cache line
+#define OMP_NUMA_BW_REPS 5 // bandwidth: best of
+
+#define OMP_NUMA_OFF 0
+#define OMP_NUMA_CLOSE 1
+#define OMP_NUMA_SPREAD 2
+
+typedef struct {
+    int nodes, cpus;
+    int detected;                         // 0: fallback, 1 node
+    int nodeId[OMP_NUMA_MAX_NODES];       // sysfs id (ids may have holes)
+    int nodeCpus[OMP_NUMA_MAX_NODES];
+    long long nodeMemMB[OMP_NUMA_MAX_NODES];
+    int cpuNode[OMP_NUMA_MAX_CPUS];       // node index, -1: not present
+} OmpTopo;
+
+// "0-15,32-47": marks cpuNode, returns the cpu count
+static inline int ompNumaParseList(const char* s, int node, OmpTopo* t) {
+    int count = 0;
+    while (*s && *s != '\n') {
+        char* e;
+        long a = strtol(s, &e, 10), b = a;
+        if (e == s)
+            break;
+        if (*e == '-')
+            b = strtol(e + 1, &e, 10);
+        for (long c = a; c <= b && c < OMP_NUMA_MAX_CPUS; c++) {
+            t->cpuNode[c] = node;
+            count++;
+        }
+        s = *e == ',' ? e + 1 : e;
+    }
+    return count;
+}
+
+static inline void ompTopo(OmpTopo* t) {
+    memset(t, 0, sizeof *t);
+    for (int c = 0; c < OMP_NUMA_MAX_CPUS; c++)
+        t->cpuNode[c] = -1;
+#ifdef __linux__
+    char path[128], line[8192];
+    for (int id = 0; id < 1024 && t->nodes < OMP_NUMA_MAX_NODES; id++) {
+        snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", id);
+        FILE* f = fopen(path, "r");
+        if (!f)
+            continue;
+        int cpus = fgets(line, sizeof line, f) ? ompNumaParseList(line, t->nodes, t) : 0;
+        fclose(f);
+        if (cpus == 0) // memory-only node (CXL, HBM): no thread can run there, skipped
+            continue;
+        int n = t->nodes++;
+        t->nodeId[n] = id;
+        t->nodeCpus[n] = cpus;
+        t->cpus += cpus;
+        snprintf(path, sizeof path, "/sys/devices/system/node/node%d/meminfo", id);
+        if ((f = fopen(path, "r"))) {
+            long long kb;
+            while (fgets(line, sizeof line, f))
+                if (sscanf(line, "Node %*d MemTotal: %lld", &kb) == 1)
+                    t->nodeMemMB[n] = kb / 1024;
+            fclose(f);
+        }
+    }
+#endif
+    t->detected = t->nodes > 0;
+    if (!t->detected) {
+        t->nodes = 1;
+        t->cpus = t->nodeCpus[0] = omp_get_num_procs();
+        for (int c = 0; c < t->cpus && c < OMP_NUMA_MAX_CPUS; c++)
+            t->cpuNode[c] = 0;
+    }
+}
+
+// Node of the calling thread's current cpu
+static inline int ompNumaNode(const OmpTopo* t) {
+#ifdef __linux__
+    int c = sched_getcpu();
+    if (c >= 0 && c < OMP_NUMA_MAX_CPUS && t->cpuNode[c] >= 0)
+        return t->cpuNode[c];
+#endif
+    return 0;
+}
+
+// Binds the calling thread to every cpu of node. 0 if not supported
+static inline int ompNumaBindNode(const OmpTopo* t, int node) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < OMP_NUMA_MAX_CPUS; c++)
+        if (t->cpuNode[c] == node)
+            CPU_SET(c, &set);
+    return sched_setaffinity(0, sizeof set, &set) == 0;
+#else
+    return 0;
+#endif
+}
+
+// OMP_NUMA, else spread unless the runtime already binds
+static inline int ompNumaPolicy(void) {
+    const char* env = getenv("OMP_NUMA");
+    if (env)
+        return !strcmp(env, "close") ? OMP_NUMA_CLOSE : !strcmp(env, "spread") ? OMP_NUMA_SPREAD : OMP_NUMA_OFF;
+    return getenv("OMP_PLACES") || getenv("OMP_PROC_BIND") ? OMP_NUMA_OFF : OMP_NUMA_SPREAD;
+}
+
+// Pins the current team (the runtime keeps its threads between regions: call again after
+// omp_set_num_threads). Returns the policy applied, OMP_NUMA_OFF on a single node
+static inline int ompNumaSetup(const OmpTopo* t, int policy) {
+    if (policy == OMP_NUMA_OFF || t->nodes < 2)
+        return OMP_NUMA_OFF;
+    #pragma omp parallel
+    {
+        int th = omp_get_thread_num(), nth = omp_get_num_threads();
+        ompNumaBindNode(t, policy == OMP_NUMA_SPREAD ? th % t->nodes : (int)((long long)th * t->nodes / nth));
+    }
+    return policy;
+}
+
+
+
+// ------ First touch ------
+// Zeroes n elements of elem bytes with the schedule(static) split of any loop over [0, n)
+// with the same team: each page lands on the node of the thread that will use it
+static inline void ompFirstTouch(void* p, long long n, size_t elem) {
+    char* c = p;
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < n; i++)
+        memset(c + i * elem, 0, elem);
+}
+
+// Page-aligned & large: fresh, untouched pages from the OS, placed by ompFirstTouch. free() it
+static inline void* ompNumaAlloc(long long n, size_t elem) {
+    size_t bytes = ((size_t)n * elem + OMP_NUMA_PAGE - 1) / OMP_NUMA_PAGE * OMP_NUMA_PAGE;
+    void* p = aligned_alloc(OMP_NUMA_PAGE, bytes ? bytes : OMP_NUMA_PAGE);
+    if (p)
+        ompFirstTouch(p, n, elem);
+    return p;
+}
+
+
+
+// ------ Per-node arena ------
+typedef struct {
+    char* base;
+    size_t cap, used;
+    int node;
+} OmpArena;
+
+// cap bytes on node: touched by the calling thread while bound there. 0 on failure
+static inline int ompArenaInit(OmpArena* a, const OmpTopo* t, int node, size_t cap) {
+    cap = (cap + OMP_NUMA_PAGE - 1) / OMP_NUMA_PAGE * OMP_NUMA_PAGE;
+    a->base = aligned_alloc(OMP_NUMA_PAGE, cap ? cap : OMP_NUMA_PAGE);
+    a->cap = a->base ? cap : 0;
+    a->used = 0;
+    a->node = node;
+    if (!a->base)
+        return 0;
+#ifdef __linux__
+    cpu_set_t old;
+    int bound = t->nodes > 1 && sched_getaffinity(0, sizeof old, &old) == 0 && ompNumaBindNode(t, node);
+    memset(a->base, 0, cap);
+    if (bound)
+        sched_setaffinity(0, sizeof old, &old);
+#else
+    memset(a->base, 0, cap);
+#endif
+    return 1;
+}
+
+// Thread-safe bump allocation, OMP_NUMA_ALIGN-aligned. NULL when full (until ompArenaReset)
+static inline void* ompArenaAlloc(OmpArena* a, size_t bytes) {
+    size_t size = (bytes + OMP_NUMA_ALIGN - 1) / OMP_NUMA_ALIGN * OMP_NUMA_ALIGN, off;
+    #pragma omp atomic capture
+    { off = a->used; a->used += size; }
+    return off + size <= a->cap ? a->base + off : NULL;
+}
+
+static inline void ompArenaReset(OmpArena* a) { a->used = 0; }
+
+static inline void ompArenaFree(OmpArena* a) {
+    free(a->base);
+    a->base = NULL;
+    a->cap = a->used = 0;
+}
+
+// 1 arena per node (a[nodes]), returns the number initialised
+static inline int ompArenasInit(OmpArena* a, const OmpTopo* t, size_t capPerNode) {
+    int ok = 0;
+    for (int n = 0; n < t->nodes; n++)
+        ok += ompArenaInit(&a[n], t, n, capPerNode);
+    return ok;
+}
+
+// Arena of the calling thread's node
+static inline OmpArena* ompArenaLocal(OmpArena* a, const OmpTopo* t) { return &a[ompNumaNode(t)]; }
+
+
+
+// ------ Report ------
+static inline void ompNumaReport(const OmpTopo* t, int policy) {
+    static const char* bindNames[] = { "false", "true", "primary", "close", "spread" };
+    static const char* policyNames[] = { "off", "close", "spread" };
+    printf("NUMA: %d node(s), %d cpus%s\n", t->nodes, t->cpus, t->detected ? "" : " (no topology found: 1 node)");
+    for (int n = 0; n < t->nodes; n++) {
+        printf("  node %d: %d cpus [", t->nodeId[n], t->nodeCpus[n]);
+        for (int c = 0, first = 1; c < OMP_NUMA_MAX_CPUS; c++)
+            if (t->cpuNode[c] == n && (c == 0 || t->cpuNode[c - 1] != n)) {
+                int e = c;
+                while (e + 1 < OMP_NUMA_MAX_CPUS && t->cpuNode[e + 1] == n)
+                    e++;
+                printf(first ? "%d" : ",%d", c);
+                if (e > c)
+                    printf("-%d", e);
+                first = 0;
+            }
+        printf("]");
+        if (t->nodeMemMB[n])
+            printf(", %lld MB", t->nodeMemMB[n]);
+        printf("\n");
+    }
+    int bind = omp_get_proc_bind();
+    const char* places = getenv("OMP_PLACES");
+    printf("OpenMP: %d threads, proc_bind %s, %d places (OMP_PLACES=%s), OMP_NUMA %s\n", omp_get_max_threads(),
+           bind >= 0 && bind <= 4 ? bindNames[bind] : "?", omp_get_num_places(), places ? places : "unset",
+           policyNames[policy]);
+
+#ifdef __linux__
+    int nt = omp_get_max_threads();
+    int* cpu = malloc(nt * sizeof(int));
+    int used = 0;
+    #pragma omp parallel
+    {
+        cpu[omp_get_thread_num()] = sched_getcpu();
+        #pragma omp single
+        used = omp_get_num_threads();
+    }
+    printf("  thread -> cpu (node):");
+    for (int i = 0; i < used; i++) {
+        int n = cpu[i] >= 0 && cpu[i] < OMP_NUMA_MAX_CPUS ? t->cpuNode[cpu[i]] : -1;
+        printf(" %d->%d(%d)", i, cpu[i], n >= 0 ? t->nodeId[n] : -1);
+    }
+    printf("\n");
+    free(cpu);
+#endif
+}
+
+// Read bandwidth (GB/s) of threads on node r from memory on node m, printed as a nodes x nodes matrix:
+// the diagonal is the per-socket local bandwidth. bytes per node. Restores every thread's affinity
+static inline void ompNumaBandwidth(const OmpTopo* t, size_t bytes) {
+    OmpArena* a = malloc(t->nodes * sizeof(OmpArena));
+    if (ompArenasInit(a, t, bytes) != t->nodes) {
+        printf("Bandwidth: cannot allocate %zu MB per node\n", bytes >> 20);
+        for (int n = 0; n < t->nodes; n++)
+            free(a[n].base);
+        free(a);
+        return;
+    }
+    long long n8 = bytes / sizeof(double);
+    double sink = 0;
+    printf("Read GB/s, threads on (row) x memory on (column):\n%8s", "");
+    for (int m = 0; m < t->nodes; m++)
+        printf("  node %-3d", t->nodeId[m]);
+    printf("\n");
+    for (int r = 0; r < t->nodes; r++) {
+        printf("node %-3d", t->nodeId[r]);
+        for (int m = 0; m < t->nodes; m++) {
+            const double* x = (const double*)a[m].base;
+            double best = 0;
+            #pragma omp parallel reduction(+: sink)
+            {
+#ifdef __linux__
+                cpu_set_t old;
+                int bound = t->nodes > 1 && sched_getaffinity(0, sizeof old, &old) == 0 && ompNumaBindNode(t, r);
+#endif
+                for (int rep = 0; rep < OMP_NUMA_BW_REPS; rep++) {
+                    double s = 0, start;
+                    #pragma omp barrier
+                    start = omp_get_wtime();
+                    #pragma omp for schedule(static)
+                    for (long long i = 0; i < n8; i++)
+                        s += x[i];
+                    // implicit barrier: every thread is done
+                    #pragma omp master
+                    {
+                        double gbs = bytes / (omp_get_wtime() - start) * 1e-9;
+                        best = gbs > best ? gbs : best;
+                    }
+                    sink += s;
+                }
+#ifdef __linux__
+                if (bound)
+                    sched_setaffinity(0, sizeof old, &old);
+#endif
+            }
+            printf("  %8.2f", best);
+        }
+        printf("\n");
+    }
+    if (sink == 1) // keeps the reads
+        printf(" ");
+    for (int n = 0; n < t->nodes; n++)
+        ompArenaFree(&a[n]);
+    free(a);
+}
+
+#endif
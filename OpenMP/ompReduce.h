@@ -0,0 +1,180 @@
+#ifndef OMP_REDUCE_H
+#define OMP_REDUCE_H
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/*
+    Parallel reductions: sum, min, max, argmax & any user-defined associative op
+    OMP_RED_DEFINE(name, T, IDENT, OP, LOAD) generates   T name(const void* ctx, long long n, int mode)
+    reducing LOAD(ctx, i) for i in [0, n) with OP (identity IDENT). LOAD reads an array or computes the element,
+    so n is not bounded by memory (e.g. the index sum of openMPmulTh.c at N = 1e10).
+
+    Inner loop: OMP_RED_LANES independent accumulators, 1 per SIMD lane (`omp simd`), combined in lane order.
+    OMP_RED_FAST: 1 contiguous range per thread, result into a cache-line-padded slot per thread,
+                  slots combined in thread order. Floating point result depends on the thread count.
+    OMP_RED_DETERMINISTIC: OMP_RED_BLOCK-element leaves (any thread), then a fixed pairwise tree over the leaves.
+                  The shape depends on n only: bitwise-identical floating point result for any thread count.
+                  This is what `ordered` inside reduction(+) was after, without serialising every iteration.
+    Integer & min / max results are the same in both modes.
+*/
+
+#define OMP_CACHE_LINE 64
+#define OMP_RED_LANES 8
+#define OMP_RED_BLOCK 8192 // deterministic mode: elements per leaf
+
+#define OMP_RED_FAST 0
+#define OMP_RED_DETERMINISTIC 1
+
+#define OMP_RED_ADD(a, b) ((a) + (b))
+#define OMP_RED_MIN(a, b) ((b) < (a) ? (b) : (a))
+#define OMP_RED_MAX(a, b) ((b) > (a) ? (b) : (a))
+
+#define OMP_RED_LOAD_D(ctx, i) (((const double*)(ctx))[i])
+#define OMP_RED_LOAD_F(ctx, i) (((const float*)(ctx))[i])
+#define OMP_RED_LOAD_LL(ctx, i) (((const long long*)(ctx))[i])
+
+// Scratch of the reductions (per-thread slots, leaves): they return a value, not a status, so exit on failure.
+// align = 0: plain malloc
+static inline void* ompRedAlloc(size_t align, size_t bytes) {
+    void* p = align ? aligned_alloc(align, bytes) : malloc(bytes);
+    if (!p) {
+        fprintf(stderr, "ompReduce: cannot allocate %zu bytes of scratch.\n", bytes);
+        exit(1);
+    }
+    return p;
+}
+
+#define OMP_RED_DEFINE(name, T, IDENT, OP, LOAD)                                                    \
+    typedef struct {                                                                                \
+        _Alignas(OMP_CACHE_LINE) T v;                                                               \
+    } name##_slot;                                                                                  \
+                                                                                                    \
+    /* [lo, hi), fixed order: lane l takes lo + l, lo + l + LANES, ..., the tail goes to lane 0 */   \
+    static inline T name##_range(const void* ctx, long long lo, long long hi) {                    \
+        (void)ctx; /* LOAD may compute the element from i alone */                                  \
+        T acc[OMP_RED_LANES];                                                                       \
+        for (int l = 0; l < OMP_RED_LANES; l++)                                                     \
+            acc[l] = (IDENT);                                                                       \
+        long long i = lo;                                                                           \
+        for (; i + OMP_RED_LANES <= hi; i += OMP_RED_LANES) {                                       \
+            _Pragma("omp simd")                                                                     \
+            for (int l = 0; l < OMP_RED_LANES; l++)                                                 \
+                acc[l] = OP(acc[l], LOAD(ctx, i + l));                                              \
+        }                                                                                           \
+        for (; i < hi; i++)                                                                         \
+            acc[0] = OP(acc[0], LOAD(ctx, i));                                                      \
+        T r = acc[0];                                                                               \
+        for (int l = 1; l < OMP_RED_LANES; l++)                                                     \
+            r = OP(r, acc[l]);                                                                      \
+        return r;                                                                                   \
+    }                                                                                               \
+                                                                                                    \
+    static inline T name(const void* ctx, long long n, int mode) {                                  \
+        T r = (IDENT);                                                                              \
+        if (n <= 0)                                                                                 \
+            return r;                                                                               \
+        if (mode == OMP_RED_FAST) {                                                                 \
+            int nt = omp_get_max_threads(), used = 1;                                               \
+            name##_slot* slot = ompRedAlloc(OMP_CACHE_LINE, nt * sizeof(name##_slot));              \
+            _Pragma("omp parallel")                                                                 \
+            {                                                                                       \
+                int t = omp_get_thread_num(), nth = omp_get_num_threads();                          \
+                if (t == 0)                                                                         \
+                    used = nth;                                                                     \
+                slot[t].v = name##_range(ctx, n / nth * t + (t < n % nth ? t : n % nth),            \
+                                         n / nth * (t + 1) + (t + 1 < n % nth ? t + 1 : n % nth));  \
+            }                                                                                       \
+            for (int t = 0; t < used; t++)                                                          \
+                r = OP(r, slot[t].v);                                                               \
+            free(slot);                                                                             \
+            return r;                                                                               \
+        }                                                                                           \
+        long long nb = (n + OMP_RED_BLOCK - 1) / OMP_RED_BLOCK;                                     \
+        T* leaf = ompRedAlloc(0, nb * sizeof(T));                                                   \
+        _Pragma("omp parallel for schedule(static)")                                                \
+        for (long long b = 0; b < nb; b++)                                                          \
+            leaf[b] = name##_range(ctx, b * OMP_RED_BLOCK,                                          \
+                                   (b + 1) * OMP_RED_BLOCK < n ? (b + 1) * OMP_RED_BLOCK : n);      \
+        /* level w: leaf[b] = leaf[b] op leaf[b + w] for b = 0, 2w, 4w, ... */                      \
+        for (long long w = 1; w < nb; w *= 2) {                                                     \
+            _Pragma("omp parallel for schedule(static)")                                            \
+            for (long long b = 0; b < nb - w; b += 2 * w)                                           \
+                leaf[b] = OP(leaf[b], leaf[b + w]);                                                 \
+        }                                                                                           \
+        r = leaf[0];                                                                                \
+        free(leaf);                                                                                 \
+        return r;                                                                                   \
+    }
+
+// ------ Predefined ------
+OMP_RED_DEFINE(ompSumD, double, 0.0, OMP_RED_ADD, OMP_RED_LOAD_D)
+OMP_RED_DEFINE(ompMinD, double, INFINITY, OMP_RED_MIN, OMP_RED_LOAD_D)
+OMP_RED_DEFINE(ompMaxD, double, -INFINITY, OMP_RED_MAX, OMP_RED_LOAD_D)
+OMP_RED_DEFINE(ompSumF, float, 0.0f, OMP_RED_ADD, OMP_RED_LOAD_F)
+OMP_RED_DEFINE(ompSumLL, long long, 0, OMP_RED_ADD, OMP_RED_LOAD_LL)
+OMP_RED_DEFINE(ompMinLL, long long, __LONG_LONG_MAX__, OMP_RED_MIN, OMP_RED_LOAD_LL)
+OMP_RED_DEFINE(ompMaxLL, long long, -__LONG_LONG_MAX__ - 1, OMP_RED_MAX, OMP_RED_LOAD_LL)
+
+
+
+// ------ Argmax ------
+// Index of the largest x[i], first one on ties (so the same in every mode & thread count). -1 if n <= 0
+typedef struct {
+    _Alignas(OMP_CACHE_LINE) double v;
+    long long i;
+} OmpArgSlot;
+
+static inline long long ompArgmaxD(const double* x, long long n) {
+    if (n <= 0)
+        return -1;
+    int nt = omp_get_max_threads(), used = 1;
+    OmpArgSlot* slot = ompRedAlloc(OMP_CACHE_LINE, nt * sizeof(OmpArgSlot));
+    #pragma omp parallel
+    {
+        int t = omp_get_thread_num(), nth = omp_get_num_threads();
+        if (t == 0)
+            used = nth;
+        long long lo = n / nth * t + (t < n % nth ? t : n % nth);
+        long long hi = n / nth * (t + 1) + (t + 1 < n % nth ? t + 1 : n % nth);
+        double bv[OMP_RED_LANES];
+        long long bi[OMP_RED_LANES];
+        for (int l = 0; l < OMP_RED_LANES; l++) {
+            bv[l] = -INFINITY;
+            bi[l] = -1;
+        }
+        long long i = lo;
+        for (; i + OMP_RED_LANES <= hi; i += OMP_RED_LANES) {
+            #pragma omp simd
+            for (int l = 0; l < OMP_RED_LANES; l++) {
+                int gt = x[i + l] > bv[l]; // strict: earliest index per lane
+                bv[l] = gt ? x[i + l] : bv[l];
+                bi[l] = gt ? i + l : bi[l];
+            }
+        }
+        for (; i < hi; i++)
+            if (x[i] > bv[0]) {
+                bv[0] = x[i];
+                bi[0] = i;
+            }
+        slot[t].v = bv[0];
+        slot[t].i = bi[0];
+        for (int l = 1; l < OMP_RED_LANES; l++)
+            if (bi[l] >= 0 && (slot[t].i < 0 || bv[l] > slot[t].v || (bv[l] == slot[t].v && bi[l] < slot[t].i))) {
+                slot[t].v = bv[l];
+                slot[t].i = bi[l];
+            }
+    }
+    long long best = -1;
+    double bestV = 0;
+    for (int t = 0; t < used; t++)
+        if (slot[t].i >= 0 && (best < 0 || slot[t].v > bestV)) { // threads in index order: > keeps the first
+            bestV = slot[t].v;
+            best = slot[t].i;
+        }
+    free(slot);
+    return best < 0 ? 0 : best; // all NaN / -inf: the first element
+}
+
+#endif
@@ -1,31 +1,138 @@
+#include "ompNuma.h" // first: defines _GNU_SOURCE
 #include <omp.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include "ompReduce.h"
 
-#define N 100000000
+#define N_MIN 100000000LL       // 1e8
+#define N_MAX 10000000000LL     // 1e10, argv[1] overrides
+#define ORDERED_MAX 100000000LL // `ordered` runs 1 iteration at a time: only timed up to here
+#define ARR_N 10000000          // min / max / argmax array
 
-int main() {
-    double start, end, t;
-    long long seq=0, para=0;
+/*
+    Sum of 0 .. N-1: sequential, the old `ordered` reduction, reduction(+), and ompReduce.h (fast & deterministic)
+    ./openMPmulTh [N_MAX]
+    Then: float sum over thread counts (deterministic mode is bitwise stable) and min / max / argmax.
+    Threads pinned per NUMA node (OMP_NUMA, ompNuma.h), the array first-touched by its users.
+*/
 
-    start = omp_get_wtime();
-    for (int i = 0; i < N; i++) {
-        seq += i;
+// Element i is i itself: nothing in memory, so N can reach 1e10. unsigned: wraps mod 2^64 like the check
+#define IDX_LOAD(ctx, i) ((unsigned long long)(i))
+OMP_RED_DEFINE(sumIdx, unsigned long long, 0ULL, OMP_RED_ADD, IDX_LOAD)
+
+// 1 / (i + 1): the float result depends on the summation order
+#define HARM_LOAD(ctx, i) (1.0 / (double)((i) + 1))
+OMP_RED_DEFINE(sumHarm, double, 0.0, OMP_RED_ADD, HARM_LOAD)
+
+int main(int argc, char** argv) {
+    double start, t;
+    long long nMax = argc > 1 ? atoll(argv[1]) : N_MAX;
+    int bad = 0;
+    OmpTopo topo;
+    ompTopo(&topo);
+    int policy = ompNumaSetup(&topo, ompNumaPolicy());
+    ompNumaReport(&topo, policy);
+
+    printf("%12s %12s %12s %12s %12s %12s   (seconds)\n", "N", "sequential", "ordered", "reduction", "lib fast", "lib determ.");
+    for (long long N = N_MIN; N <= nMax; N *= 10) {
+        // N (N - 1) / 2 mod 2^64
+        unsigned long long expect = N % 2 ? (unsigned long long)N * ((N - 1) / 2) : (unsigned long long)(N / 2) * (N - 1);
+        unsigned long long seq = 0, para = 0, r;
+        double tSeq, tOrd = -1, tRed, tFast, tDet;
+
+        start = omp_get_wtime();
+        for (long long i = 0; i < N; i++) {
+            seq += i;
+        }
+        tSeq = omp_get_wtime() - start;
+
+        // The old loop: ordered inside reduction(+) serialises every iteration
+        if (N <= ORDERED_MAX) {
+            start = omp_get_wtime();
+            #pragma omp parallel for reduction(+: para) ordered
+            for (long long i = 0; i < N; i++) {
+                #pragma omp ordered
+                para += i;
+            }
+            tOrd = omp_get_wtime() - start;
+            bad += para != expect;
+        }
+
+        para = 0;
+        start = omp_get_wtime();
+        #pragma omp parallel for reduction(+: para)
+        for (long long i = 0; i < N; i++) {
+            para += i;
+        }
+        tRed = omp_get_wtime() - start;
+        bad += para != expect;
+
+        start = omp_get_wtime();
+        r = sumIdx(NULL, N, OMP_RED_FAST);
+        tFast = omp_get_wtime() - start;
+        bad += r != expect;
+
+        start = omp_get_wtime();
+        r = sumIdx(NULL, N, OMP_RED_DETERMINISTIC);
+        tDet = omp_get_wtime() - start;
+        bad += r != expect || seq != expect;
+
+        printf("%12lld %12f ", N, tSeq);
+        if (tOrd < 0)
+            printf("%12s ", "-");
+        else
+            printf("%12f ", tOrd);
+        printf("%12f %12f %12f\n", tRed, tFast, tDet);
     }
-    end = omp_get_wtime();
-    t = end - start;
-    printf("Sequential Execution time: %f seconds\n", t);
 
-    // Must assign: ordered in/outside for loop
-    start = omp_get_wtime();
-    #pragma omp parallel for reduction(+: para) ordered
-    for (int i = 0; i < N; i++) {
-        #pragma omp ordered
-        para += i;
+    // ------ Float: reproducibility over thread counts ------
+    int maxTh = omp_get_max_threads();
+    double det1 = 0, fast1 = 0;
+    int detSame = 1, fastSame = 1;
+    for (int th = 1; th <= maxTh; th = (th * 2 > maxTh && th != maxTh) ? maxTh : th * 2) {
+        omp_set_num_threads(th);
+        double f = sumHarm(NULL, N_MIN, OMP_RED_FAST);
+        double d = sumHarm(NULL, N_MIN, OMP_RED_DETERMINISTIC);
+        if (th == 1) {
+            fast1 = f;
+            det1 = d;
+        }
+        fastSame &= memcmp(&f, &fast1, sizeof(double)) == 0;
+        detSame &= memcmp(&d, &det1, sizeof(double)) == 0;
+        printf("sum 1/(i+1), %2d threads: fast %.17g, deterministic %.17g\n", th, f, d);
     }
-    end = omp_get_wtime();
-    t = end - start;
-    printf("Execution time: %f seconds\n", t);
+    omp_set_num_threads(maxTh);
+    ompNumaSetup(&topo, policy);
+    printf("Bitwise identical over thread counts: fast %s, deterministic %s\n", fastSame ? "yes" : "no", detSame ? "yes" : "no");
+    bad += !detSame;
+
+    // ------ min / max / argmax ------
+    double* x = ompNumaAlloc(ARR_N, sizeof(double));
+    if (!x) {
+        printf(" Cannot allocate %d doubles.\n", ARR_N);
+        return 1;
+    }
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < ARR_N; i++)
+        x[i] = (double)((i * 7919) % 1000003) - 500000.0;
+    double mn = x[0], mx = x[0];
+    long long am = 0;
+    for (long long i = 1; i < ARR_N; i++) {
+        if (x[i] < mn) mn = x[i];
+        if (x[i] > mx) { mx = x[i]; am = i; }
+    }
+    start = omp_get_wtime();
+    double lmn = ompMinD(x, ARR_N, OMP_RED_FAST), lmx = ompMaxD(x, ARR_N, OMP_RED_FAST);
+    long long lam = ompArgmaxD(x, ARR_N);
+    t = omp_get_wtime() - start;
+    printf("min %g, max %g at %lld (%f s for all 3)%s\n", lmn, lmx, lam, t,
+           lmn == mn && lmx == mx && lam == am ? "" : ", MISMATCH vs sequential");
+    bad += lmn != mn || lmx != mx || lam != am;
+    free(x);
+    if (bad)
+        printf("%d MISMATCH(ES)\n", bad);
 
 
 
@@ -57,5 +164,5 @@ int main() {
 }
 
 /* Compile
-    gcc -fopenmp <file>.c -o <file>.exe 
+    gcc -O2 -fopenmp <file>.c -o <file>.exe -lm
 */
\ No newline at end of file